@@ -0,0 +1,651 @@
+/**
+  ******************************************************************************
+  * @file    at_engine.c
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file sends the queued AT commands to the GSM module without blocking
+  ******************************************************************************
+  *
+  *					HOW TO USE
+  * 1. Queue the commands with AT_QueueCommand(). Commands are sent one after the other in the same order.
+  *    Command is kept in the flash, ex: PSTR("AT+CMGD=%s"). Argument is in the RAM (%s) or in the flash (%S),
+  *    terminator and response are in the RAM.
+  * 2. Call AT_Poll() from the main loop. It sends the next command, collects the response in gGSM_Response
+  *    and calls the callback of the command with the status once the final response is received or timed out.
+  * 3. Response is valid only inside the callback, USART_GetLines() gives its lines including the final response.
+  *    Callback can queue the next command of the chain.
+  * 4. Unsolicited result codes in the table set by AT_SetURCTable() are given to their handlers as soon as
+  *    they are received, even while a command is running. They are not part of the response of the command.
+  *    Other lines received while no command is running are dropped.
+  *    Line after the information responses in DATA_RESPONSE[] (ex: message of +CMGR) is data, it is kept in
+  *    the response as it is, without matching it with the URC table or the final result codes.
+  * 5. AT_SendCommand() blocks till the command is complete, use it only outside of the callbacks (ex: during startup)
+  * 6. AT_QueueUrgent() puts the command in front of the queue, next to the running command (ex: ATH to reject a call).
+  *    Message body after the '>' prompt has to be queued with it, so that nothing is sent in between.
+  * 7. Timeout of the command is the maximum wait. Latency of each class of commands (AT_CLASS_xxx) is learnt from
+  *    the responses, once it is known the command times out at AT_Timeout() instead. Save AT_GetTimings() in the
+  *    EEPROM when AT_TimingsChanged() and give them back with AT_SetTimings() after the reset.
+  * 8. After a timeout, next command is held till the late final response is received or AT_LATE_RESPONSE_WAIT,
+  *    so that it is not taken as the response of the next command.
+  ******************************************************************************
+  */
+
+/*************************************************************************************************
+ * #includes
+ *************************************************************************************************/
+#include "at_engine.h"
+
+/*************************************************************************************************
+ * Global Variables and Definition
+ *************************************************************************************************/
+//Final result codes, id is 0x01 if the result code is followed by the error code
+static const struct
+{
+	uint8_t id;
+	char data[12];
+}FINAL_RESPONSE[] PROGMEM =
+{
+	{0x00, "OK"},
+	{0x00, "ERROR"},
+	{0x01, "+CME ERROR:"},
+	{0x01, "+CMS ERROR:"},
+};
+static const uint8_t gTotalFinalResponses = sizeof(FINAL_RESPONSE)/sizeof(FINAL_RESPONSE[0]);
+
+//Information responses followed by a data line, ex: message of +CMGR. Message can be "OK" or "RING" as well
+static const char DATA_RESPONSE[][8] PROGMEM =
+{
+	"+CMGL: ",
+	"+CMGR: ",
+};
+static const uint8_t gTotalDataResponses = sizeof(DATA_RESPONSE)/sizeof(DATA_RESPONSE[0]);
+
+//Class of the command, the first entry found in the command is taken. Others are AT_CLASS_LOCAL
+static const struct
+{
+	uint8_t id;
+	char data[8];
+}COMMAND_CLASS[] PROGMEM =
+{
+	{AT_CLASS_PURGE, "+CMGDA"},
+	{AT_CLASS_STORAGE, "+CMGD"},
+	{AT_CLASS_STORAGE, "+CMGL"},
+	{AT_CLASS_STORAGE, "+CMGR"},
+	{AT_CLASS_STORAGE, "+CPMS"},
+	{AT_CLASS_PROMPT, "+CMGS="},
+	{AT_CLASS_NETWORK, "ATD"},
+	{AT_CLASS_NETWORK, "+CREG"},
+	{AT_CLASS_NETWORK, "+CSQ"},
+	{AT_CLASS_NETWORK, "+IPR"},
+	{AT_CLASS_CALL, "ATA"},
+	{AT_CLASS_CALL, "ATH"},
+	{AT_CLASS_CALL, "+VTS"},
+};
+static const uint8_t gTotalCommandClasses = sizeof(COMMAND_CLASS)/sizeof(COMMAND_CLASS[0]);
+
+//Least adaptive timeout of each class in milliseconds, a quick modem should not cut the slow answers of the class
+static const uint16_t CLASS_FLOOR[AT_TOTAL_CLASSES] PROGMEM =
+{
+	AT_TIMEOUT_FLOOR,	// AT_CLASS_LOCAL
+	1000,				// AT_CLASS_STORAGE
+	5000,				// AT_CLASS_PURGE
+	1000,				// AT_CLASS_NETWORK
+	3000,				// AT_CLASS_CALL, ATA waits for the call to connect
+	1000,				// AT_CLASS_PROMPT
+	10000,				// AT_CLASS_MESSAGE
+};
+
+static Struct_AT_Timing gTimings[AT_TOTAL_CLASSES] =
+{
+	{AT_TIMEOUT_UNKNOWN, 0}, {AT_TIMEOUT_UNKNOWN, 0}, {AT_TIMEOUT_UNKNOWN, 0}, {AT_TIMEOUT_UNKNOWN, 0},
+	{AT_TIMEOUT_UNKNOWN, 0}, {AT_TIMEOUT_UNKNOWN, 0}, {AT_TIMEOUT_UNKNOWN, 0},
+};
+static uint8_t gSamples[AT_TOTAL_CLASSES];			// Responses learnt since the reset, saturates at AT_TIMEOUT_WARM_UP
+static uint16_t gSavedAverage[AT_TOTAL_CLASSES] =
+{
+	AT_TIMEOUT_UNKNOWN, AT_TIMEOUT_UNKNOWN, AT_TIMEOUT_UNKNOWN, AT_TIMEOUT_UNKNOWN,
+	AT_TIMEOUT_UNKNOWN, AT_TIMEOUT_UNKNOWN, AT_TIMEOUT_UNKNOWN,
+};
+
+static Struct_AT_Command gQueue[AT_QUEUE_LENGTH];
+static uint8_t gQueueHead = 0;
+static uint8_t gQueueTail = 0;
+
+static uint8_t gActive = 0;			// Set while the command at gQueueTail is waiting for the response
+static uint32_t gDeadline;
+static uint32_t gSentAt;			// Tick at which the running command is sent
+static uint8_t gActiveClass;		// AT_CLASS_xxx of the running command
+static uint8_t gAdaptive = 0;		// Set if the running command has the learnt timeout, not its own
+static uint8_t gLate = 0;			// Set after a timeout till the late final response is received
+static uint32_t gLateDeadline;		// Next command is sent after this even if the late response is not received
+static const Struct_URC* gURCTable = 0;
+static uint8_t gTotalURCs = 0;
+static AT_URCHandler gNextLineHandler = 0;	// Takes the line which follows an URC, ex: message of +CMT
+static uint8_t gKeepNextLine = 0;		// Next line is data of the running command, see AT_IsDataResponse()
+
+static volatile uint8_t gBlockingDone;
+static uint8_t gBlockingStatus;
+
+/*************************************************************************************************
+ * Function Definition
+ *************************************************************************************************/
+/*
+ * @name   	AT_IsFinalResponse()
+ * @brief	This function checks whether the line is a final result code of an AT command
+ * @param  	line - null terminated line received from the GSM module
+ * @retval	0x01	- if the line is OK, ERROR, +CME ERROR, +CMS ERROR or '>' prompt
+ *			0x00	- otherwise
+ */
+uint8_t AT_IsFinalResponse(const char* line)
+{
+	uint8_t i;
+
+	if(line[0] == 0x3E)		// '>' prompt to compose the message
+		return 0x01;
+
+	for(i = 0; i < gTotalFinalResponses; i++)
+	{
+		if(strncmp_P(line, FINAL_RESPONSE[i].data, strlen_P(FINAL_RESPONSE[i].data)) == 0)
+		{
+			//OK and ERROR should be complete line, +CME ERROR: and +CMS ERROR: are followed by the error code
+			if((pgm_read_byte(&FINAL_RESPONSE[i].id) != 0x00) || (strlen(line) == strlen_P(FINAL_RESPONSE[i].data)))
+				return 0x01;
+		}
+	}
+
+	return 0x00;
+}
+
+/*
+ * @name   	AT_IsDataResponse()
+ * @brief	This function checks whether the line is an information response followed by a data line
+ * @param  	line - null terminated line received from the GSM module
+ * @retval	0x01	- if the line starts with one of DATA_RESPONSE[]
+ *			0x00	- otherwise
+ */
+static uint8_t AT_IsDataResponse(const char* line)
+{
+	uint8_t i;
+
+	for(i = 0; i < gTotalDataResponses; i++)
+	{
+		if(strncmp_P(line, DATA_RESPONSE[i], strlen_P(DATA_RESPONSE[i])) == 0)
+			return 0x01;
+	}
+
+	return 0x00;
+}
+
+/*
+ * @name   	AT_MatchURC()
+ * @brief	This function looks for the unsolicited result code which the line starts with
+ * @param  	line - null terminated line received from the GSM module
+ * @retval	Struct_URC* - matching entry of the URC table, NULL if the line is not an URC
+ * @note	URC table is sorted, so the entries with the same prefix are next to each other and work as a trie.
+ *			Range of the entries is narrowed one character of the line at a time, entries are never compared in full.
+ *			Table is in the flash, so the returned entry is read with pgm_read_xxx().
+ */
+static const Struct_URC* AT_MatchURC(const char* line)
+{
+	uint8_t first = 0;
+	uint8_t last = gTotalURCs;		// One after the last entry in range
+	uint8_t depth;
+	uint8_t ch;
+
+	for(depth = 0; first < last; depth++)
+	{
+		//Prefix of the first entry is complete, sorting keeps the shortest prefix first
+		if(pgm_read_byte(&gURCTable[first].prefix[depth]) == '\0')
+			return &gURCTable[first];
+
+		ch = (uint8_t)line[depth];
+		while((first < last) && (pgm_read_byte(&gURCTable[first].prefix[depth]) < ch))
+			first++;
+		while((first < last) && (pgm_read_byte(&gURCTable[last - 1].prefix[depth]) > ch))
+			last--;
+	}
+
+	return 0;
+}
+
+/*
+ * @name   	AT_IsOwnResponse()
+ * @brief	This function checks whether the line looking like an URC is the response of the running command
+ * @param  	command - running AT command, in the flash
+ *			prefix  - prefix of the matched URC, in the flash
+ * @retval	0x01	- if the command is the same as URC, ex: +CREG: for AT+CREG?
+ *			0x00	- otherwise
+ */
+static uint8_t AT_IsOwnResponse(const char* command, const char* prefix)
+{
+	uint8_t i;
+	uint8_t ch;
+
+	if((pgm_read_byte(&prefix[0]) != '+') || (pgm_read_byte(&command[0]) != 'A') || (pgm_read_byte(&command[1]) != 'T'))
+		return 0x00;
+
+	for(i = 0; ((ch = pgm_read_byte(&prefix[i])) != ':') && (ch != '\0'); i++)
+	{
+		if(pgm_read_byte(&command[i + 2]) != ch)
+			return 0x00;
+	}
+
+	return 0x01;
+}
+
+/*
+ * @name   	AT_ClassOf()
+ * @brief	This function finds the class of the command by the latency of the modem
+ * @param  	cmd - command to be sent
+ * @retval	AT_CLASS_xxx
+ * @note	Commands are searched, not only their start, so that a line of several commands takes the slowest one
+ *			(ex: ATE0;+CPMS=...). Message body after the prompt has its own class.
+ *			Command "%s" is searched in its argument, others in the first AT_CLASS_TEXT_LENGTH characters.
+ */
+static uint8_t AT_ClassOf(const Struct_AT_Command* cmd)
+{
+	char text[AT_CLASS_TEXT_LENGTH];
+	const char* command = text;
+	uint8_t i;
+
+	if(strcmp(cmd->terminator, AT_END_MESSAGE) == 0)
+		return AT_CLASS_MESSAGE;
+
+	if((cmd->argument) && (strcmp_P("%s", cmd->command) == 0))
+		command = cmd->argument;
+	else
+	{
+		strncpy_P(text, cmd->command, sizeof(text) - 1);
+		text[sizeof(text) - 1] = '\0';
+	}
+
+	for(i = 0; i < gTotalCommandClasses; i++)
+	{
+		if(strstr_P(command, COMMAND_CLASS[i].data))
+			return pgm_read_byte(&COMMAND_CLASS[i].id);
+	}
+
+	return AT_CLASS_LOCAL;
+}
+
+/*
+ * @name   	AT_Timeout()
+ * @brief	This function gives the timeout of the command from the latency learnt for its class
+ * @param  	class   - AT_CLASS_xxx
+ *			maximum - timeout of the command
+ * @retval	Timeout in milliseconds
+ * @note	Till the class has AT_TIMEOUT_WARM_UP samples, the timeout of the command is used as it is
+ */
+static uint16_t AT_Timeout(uint8_t class, uint16_t maximum)
+{
+	uint32_t timeout;
+
+	if(gSamples[class] < AT_TIMEOUT_WARM_UP)
+		return maximum;
+
+	timeout = (uint32_t)gTimings[class].average + ((uint32_t)gTimings[class].deviation * AT_TIMEOUT_DEVIATIONS) + AT_TIMEOUT_MARGIN;
+	if(timeout < pgm_read_word(&CLASS_FLOOR[class]))
+		timeout = pgm_read_word(&CLASS_FLOOR[class]);
+
+	return (timeout < maximum) ? (uint16_t)timeout : maximum;
+}
+
+/*
+ * @name   	AT_Learn()
+ * @brief	This function updates the latency of the class with the running command
+ * @param  	status - completion status of the command
+ * @retval	None
+ * @note	Average moves 1/8 and the deviation 1/4 towards the new sample, as the round trip time of TCP.
+ *			Timeout before the learnt value doubles the average, so that a slower modem is learnt quickly.
+ *			Timeout at the maximum of the command is not learnt, modem is not responding.
+ */
+static void AT_Learn(uint8_t status)
+{
+	Struct_AT_Timing* timing = &gTimings[gActiveClass];
+	uint32_t sample;
+	int32_t error;
+
+	if(status == AT_TIMED_OUT)
+	{
+		if((gAdaptive) && (timing->average != AT_TIMEOUT_UNKNOWN))
+			timing->average = (timing->average < (AT_TIMEOUT_UNKNOWN / 2)) ? (timing->average * 2) : (AT_TIMEOUT_UNKNOWN - 1);
+		return;
+	}
+
+	sample = TIMER_GetTicks() - gSentAt;
+	if(sample >= AT_TIMEOUT_UNKNOWN)
+		sample = AT_TIMEOUT_UNKNOWN - 1;
+
+	if(timing->average == AT_TIMEOUT_UNKNOWN)
+	{
+		timing->average = (uint16_t)sample;
+		timing->deviation = (uint16_t)(sample / 2);
+	}
+	else
+	{
+		error = (int32_t)sample - timing->average;
+		timing->average = (uint16_t)((int32_t)timing->average + (error / 8));
+		if(error < 0)
+			error = -error;
+		timing->deviation = (uint16_t)((int32_t)timing->deviation + ((error - timing->deviation) / 4));
+	}
+
+	if(gSamples[gActiveClass] < AT_TIMEOUT_WARM_UP)
+		gSamples[gActiveClass]++;
+}
+
+/*
+ * @name   	AT_QueueCommand()
+ * @brief	This function adds the command to the queue and returns at once
+ * @param  	command    - AT command or message body in the flash (PSTR). %s is replaced with argument
+ *			argument   - argument for the command, can be NULL. Should be valid till the command is sent
+ *			terminator - AT_END_LINE or AT_END_MESSAGE
+ *			response   - expected final response
+ *			timeout    - maximum wait for the final response in milliseconds
+ *			callback   - called with the status once the command is complete, can be NULL
+ * @retval	0x00	- if command is queued
+ *			0xFF	- if queue is full
+ */
+uint8_t AT_QueueCommand(const char* command, const char* argument, const char* terminator, const char* response, uint16_t timeout, AT_Callback callback)
+{
+	Struct_AT_Command *cmd;
+
+	if((uint8_t)(gQueueHead - gQueueTail) >= AT_QUEUE_LENGTH)
+		return AT_FAILED;
+
+	cmd = &gQueue[gQueueHead & AT_QUEUE_MASK];
+	cmd->command = command;
+	cmd->argument = argument;
+	cmd->terminator = terminator;
+	cmd->response = response;
+	cmd->timeout = timeout;
+	cmd->callback = callback;
+	gQueueHead++;
+
+	return AT_SUCCESS;
+}
+
+/*
+ * @name   	AT_QueueUrgent()
+ * @brief	This function adds the command to the front of the queue, it is sent as soon as the running command is complete
+ * @param  	Same as AT_QueueCommand()
+ * @retval	0x00	- if command is queued
+ *			0xFF	- if queue is full
+ * @note	Running command stays at gQueueTail, so it is moved one entry back to make the space next to it
+ */
+uint8_t AT_QueueUrgent(const char* command, const char* argument, const char* terminator, const char* response, uint16_t timeout, AT_Callback callback)
+{
+	Struct_AT_Command *cmd;
+
+	if((uint8_t)(gQueueHead - gQueueTail) >= AT_QUEUE_LENGTH)
+		return AT_FAILED;
+
+	gQueueTail--;
+	cmd = &gQueue[gQueueTail & AT_QUEUE_MASK];
+	if(gActive)
+	{
+		*cmd = gQueue[(gQueueTail + 1) & AT_QUEUE_MASK];
+		cmd = &gQueue[(gQueueTail + 1) & AT_QUEUE_MASK];
+	}
+	cmd->command = command;
+	cmd->argument = argument;
+	cmd->terminator = terminator;
+	cmd->response = response;
+	cmd->timeout = timeout;
+	cmd->callback = callback;
+
+	return AT_SUCCESS;
+}
+
+/*
+ * @name   	AT_Complete()
+ * @brief	This function removes the running command from the queue and calls its callback
+ * @param  	status - AT_SUCCESS, AT_FAILED or AT_TIMED_OUT
+ * @retval	None
+ * @note	Command is removed before calling the callback, so that callback can queue the next command.
+ *			Receive buffer is flushed after the callback. After a timeout the next command waits for the late response.
+ */
+static void AT_Complete(uint8_t status)
+{
+	AT_Callback callback = gQueue[gQueueTail & AT_QUEUE_MASK].callback;
+
+	AT_Learn(status);
+	gQueueTail++;
+	gActive = 0;
+	gKeepNextLine = 0;
+
+	if(status == AT_TIMED_OUT)
+	{
+		gLate = 1;
+		gLateDeadline = TIMER_GetTicks() + AT_LATE_RESPONSE_WAIT;
+	}
+
+	if(callback)
+		callback(status);
+
+	USART_FlushReceiveBuffer();
+}
+
+/*
+ * @name   	AT_Poll()
+ * @brief	This function runs the AT command queue, it has to be called from the main loop
+ * @param  	None
+ * @retval	None
+ * @note	Unsolicited result codes are given to their handlers and taken out of gGSM_Response.
+ *			When no command is running, next command is sent. It is held after a timeout, see gLate.
+ *			When a command is running, lines are collected in gGSM_Response till the final response is received.
+ */
+void AT_Poll()
+{
+	Struct_AT_Command *cmd = &gQueue[gQueueTail & AT_QUEUE_MASK];
+	const Struct_URC* urc;
+	AT_URCHandler handler;
+	const char* line;
+	uint16_t timeout;
+
+	while(USART_FillReceiveBuffer())
+	{
+		line = (const char*)USART_GetLastLine();
+
+		if((gNextLineHandler) && (line[0] != '\0'))
+		{
+			handler = gNextLineHandler;
+			gNextLineHandler = 0;
+			handler(line);
+			USART_DiscardLastLine();
+			cmd = &gQueue[gQueueTail & AT_QUEUE_MASK];	// Handler can queue an urgent command
+			continue;
+		}
+
+		//Data line is kept in the response as it is. Blank message is followed by the next information response
+		if((gKeepNextLine) && (line[0] != '\0'))
+		{
+			gKeepNextLine = AT_IsDataResponse(line);
+			continue;
+		}
+
+		urc = AT_MatchURC(line);
+		if((urc) && ((!gActive) || (!AT_IsOwnResponse(cmd->command, urc->prefix))))
+		{
+			handler = (AT_URCHandler)pgm_read_ptr(&urc->handler);
+			handler(line);
+			USART_DiscardLastLine();
+			cmd = &gQueue[gQueueTail & AT_QUEUE_MASK];
+		}
+		else if(!gActive)
+		{
+			if(AT_IsFinalResponse(line))
+				gLate = 0;		// Late response of the timed out command is dropped
+			USART_FlushReceiveBuffer();
+		}
+		else if(AT_IsFinalResponse(line))
+		{
+			AT_Complete((strcmp(line, cmd->response) == 0) ? AT_SUCCESS : AT_FAILED);
+			return;
+		}
+		else
+			gKeepNextLine = AT_IsDataResponse(line);
+	}
+
+	if(gActive)
+	{
+		if(TIMER_Expired(gDeadline))
+			AT_Complete(AT_TIMED_OUT);
+	}
+	else if((gQueueHead != gQueueTail) && ((!gLate) || TIMER_Expired(gLateDeadline)))
+	{
+		gLate = 0;
+		USART_FlushReceiveBuffer();
+		if(cmd->argument)
+			print_P(cmd->command, cmd->argument);
+		else
+			print_P(cmd->command);
+		print(cmd->terminator);
+
+		gActiveClass = AT_ClassOf(cmd);
+		timeout = AT_Timeout(gActiveClass, cmd->timeout);
+		gAdaptive = (timeout < cmd->timeout) ? 1 : 0;
+		gSentAt = TIMER_GetTicks();
+		gDeadline = gSentAt + timeout;
+		gActive = 1;
+	}
+}
+
+/*
+ * @name   	AT_IsIdle()
+ * @brief	This function checks whether all the queued commands are complete
+ * @param  	None
+ * @retval	0x01	- if no command is running or waiting
+ *			0x00	- otherwise
+ */
+uint8_t AT_IsIdle()
+{
+	return ((!gActive) && (gQueueHead == gQueueTail)) ? 0x01 : 0x00;
+}
+
+/*
+ * @name   	AT_SetURCTable()
+ * @brief	This function sets the table of unsolicited result codes and their handlers
+ * @param  	table - URC table in the flash (PROGMEM), has to be sorted by the prefix (ASCII order)
+ *			count - number of entries in the table
+ * @retval	None
+ * @note	Handlers are called from AT_Poll(). They can queue the commands but should not wait for them.
+ */
+void AT_SetURCTable(const Struct_URC* table, uint8_t count)
+{
+	gURCTable = table;
+	gTotalURCs = count;
+}
+
+/*
+ * @name   	AT_CaptureNextLine()
+ * @brief	This function gives the next non blank line to the handler, instead of the URC table or the running command
+ * @param  	handler - called once with the line
+ * @retval	None
+ * @note	Called from an URC handler when the URC is followed by a data line, ex: +CMT header and the message.
+ *			Data line of a response (DATA_RESPONSE[]) is captured by the engine itself and kept in the response
+ */
+void AT_CaptureNextLine(AT_URCHandler handler)
+{
+	gNextLineHandler = handler;
+}
+
+/*
+ * @name   	AT_BlockingDone()
+ * @brief	Callback of AT_SendCommand()
+ * @param  	status - status of the command
+ * @retval	None
+ */
+static void AT_BlockingDone(uint8_t status)
+{
+	gBlockingStatus = status;
+	gBlockingDone = 1;
+}
+
+/*
+ * @name   	AT_SendCommand()
+ * @brief	This function sends the AT command and waits till it is complete
+ * @param  	command  - AT command in the flash (PSTR), %s is replaced with argument
+ *			argument - argument for the command, can be NULL
+ *			response - expected final response
+ *			timeout  - maximum wait for the final response in milliseconds
+ * @retval	AT_SUCCESS, AT_FAILED or AT_TIMED_OUT
+ * @note	Commands which are already in the queue are sent first. Should not be called from a callback!
+ */
+uint8_t AT_SendCommand(const char* command, const char* argument, const char* response, uint16_t timeout)
+{
+	gBlockingDone = 0;
+	if(AT_QueueCommand(command, argument, AT_END_LINE, response, timeout, AT_BlockingDone))
+		return AT_FAILED;
+
+	while(!gBlockingDone)
+		AT_Poll();
+
+	return gBlockingStatus;
+}
+
+/*
+ * @name   	AT_SetTimings()
+ * @brief	This function gives back the latencies saved before the reset
+ * @param  	timings - AT_TOTAL_CLASSES entries, as given by AT_GetTimings()
+ * @retval	None
+ * @note	Classes with AT_TIMEOUT_UNKNOWN (erased EEPROM) are learnt again
+ */
+void AT_SetTimings(const Struct_AT_Timing* timings)
+{
+	uint8_t i;
+
+	for(i = 0; i < AT_TOTAL_CLASSES; i++)
+	{
+		gTimings[i] = timings[i];
+		gSavedAverage[i] = timings[i].average;
+		gSamples[i] = (timings[i].average != AT_TIMEOUT_UNKNOWN) ? AT_TIMEOUT_WARM_UP : 0;
+	}
+}
+
+/*
+ * @name   	AT_TimingsChanged()
+ * @brief	This function checks whether the latencies are worth saving again
+ * @param  	None
+ * @retval	0x01	- if the average of a class is learnt or moved by more than a quarter since AT_GetTimings()
+ *			0x00	- otherwise
+ * @note	Small changes are not saved to spare the EEPROM writes
+ */
+uint8_t AT_TimingsChanged()
+{
+	uint8_t i;
+	uint32_t saved;
+	uint32_t average;
+
+	for(i = 0; i < AT_TOTAL_CLASSES; i++)
+	{
+		saved = gSavedAverage[i];
+		average = gTimings[i].average;
+		if(average == saved)
+			continue;
+		if((saved == AT_TIMEOUT_UNKNOWN) || (average == AT_TIMEOUT_UNKNOWN))
+			return 0x01;
+		if((average > (saved + (saved / 4))) || (average < (saved - (saved / 4))))
+			return 0x01;
+	}
+
+	return 0x00;
+}
+
+/*
+ * @name   	AT_GetTimings()
+ * @brief	This function gives the latencies learnt for all the classes, to be saved
+ * @param  	None
+ * @retval	Struct_AT_Timing* - AT_TOTAL_CLASSES entries
+ * @note	They are taken as saved by AT_TimingsChanged()
+ */
+const Struct_AT_Timing* AT_GetTimings()
+{
+	uint8_t i;
+
+	for(i = 0; i < AT_TOTAL_CLASSES; i++)
+		gSavedAverage[i] = gTimings[i].average;
+
+	return gTimings;
+}
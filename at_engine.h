@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    at_engine.h
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This is a header file for at_engine.c
+  ******************************************************************************
+  */
+
+#ifndef _AT_ENGINE_H_
+#define _AT_ENGINE_H_
+
+/*************************************************************************************************
+ * #includes
+ *************************************************************************************************/
+#include<stdio.h>
+#include<string.h>
+#include "atmega328p_usart.h"
+#include "atmega328p_timer.h"
+#include "printf_code.h"
+
+/*************************************************************************************************
+ * #defines
+ *************************************************************************************************/
+#define AT_QUEUE_LENGTH			4		// Must be power of 2!
+#define AT_QUEUE_MASK			(AT_QUEUE_LENGTH - 1)
+
+#if ((AT_QUEUE_LENGTH & AT_QUEUE_MASK) != 0)
+#error "AT_QUEUE_LENGTH must be a power of 2"
+#endif
+
+//Completion status passed to the callback
+#define AT_SUCCESS				0x00	// Expected final response is received
+#define AT_TIMED_OUT			0xFE	// Final response is not received with in the timeout
+#define AT_FAILED				0xFF	// Other final response is received, or the command could not be queued
+
+//Classes of the commands by the latency of the modem, each class learns its own timeout
+#define AT_CLASS_LOCAL			0x00	// Answered by the modem itself, ex: AT, ATE0, AT+CMGF
+#define AT_CLASS_STORAGE		0x01	// Reads or writes the SIM, ex: AT+CMGL, AT+CMGD, AT+CPMS
+#define AT_CLASS_PURGE			0x02	// AT+CMGDA, deletes all the messages
+#define AT_CLASS_NETWORK		0x03	// Asks the network, ex: ATD, AT+CREG?, AT+CSQ, AT+IPR
+#define AT_CLASS_CALL			0x04	// Controls the call, ex: ATA, ATH0, AT+VTS
+#define AT_CLASS_PROMPT			0x05	// Waits for the '>' prompt, AT+CMGS=
+#define AT_CLASS_MESSAGE		0x06	// Message body after the '>' prompt, sent to the network
+#define AT_TOTAL_CLASSES		0x07
+
+//Adaptive timeout = average + (AT_TIMEOUT_DEVIATIONS x deviation) + AT_TIMEOUT_MARGIN, limited by the timeout of the command
+#define AT_TIMEOUT_DEVIATIONS	4
+#define AT_TIMEOUT_MARGIN		100		// Milliseconds, covers the time to print the command and poll
+#define AT_TIMEOUT_FLOOR		300		// Milliseconds, adaptive timeout is never less than this, see CLASS_FLOOR[] for the slower classes
+#define AT_TIMEOUT_WARM_UP		4		// Samples needed before the adaptive timeout is used
+#define AT_TIMEOUT_UNKNOWN		0xFFFF	// Average of a class which is not learnt yet (erased EEPROM)
+#define AT_LATE_RESPONSE_WAIT	1000	// Milliseconds, next command waits this long for the final response of a timed out command
+
+#define AT_URC_PREFIX_LENGTH	12		// Longest prefix of the URC table, with the null character
+#define AT_CLASS_TEXT_LENGTH	32		// Start of the command searched for its class, see AT_ClassOf()
+
+//Terminators
+#define AT_END_LINE				"\r\n"		// End of AT command
+#define AT_END_MESSAGE			"\x1A"		// Ctrl+Z, end of the message body
+
+/*************************************************************************************************
+ * Strcuture Definitions
+ *************************************************************************************************/
+typedef void (*AT_Callback)(uint8_t status);
+typedef void (*AT_URCHandler)(const char* line);
+
+typedef struct
+{
+	char prefix[AT_URC_PREFIX_LENGTH];	// Start of the unsolicited result code, ex: "+CMTI: "
+	AT_URCHandler handler;		// Called with the complete line
+}Struct_URC;		// URC table is kept in the flash (PROGMEM)
+
+typedef struct
+{
+	uint16_t average;			// Smoothed latency in milliseconds, AT_TIMEOUT_UNKNOWN till it is learnt
+	uint16_t deviation;			// Smoothed mean deviation of the latency in milliseconds
+}Struct_AT_Timing;
+
+typedef struct
+{
+	const char* command;		// AT command or message body in the flash (PSTR), %s in it is replaced with argument
+	const char* argument;		// In the RAM for %s, in the flash for %S. Should be valid till the command is sent
+	const char* terminator;		// AT_END_LINE or AT_END_MESSAGE
+	const char* response;		// Expected final response, "OK" or ">"
+	uint16_t timeout;			// Maximum wait for the final response in milliseconds, see AT_Timeout()
+	AT_Callback callback;		// Called once the command is complete, can be NULL
+}Struct_AT_Command;
+
+/*************************************************************************************************
+ * Exported Functions
+ *************************************************************************************************/
+uint8_t AT_QueueCommand(const char*, const char*, const char*, const char*, uint16_t, AT_Callback);
+uint8_t AT_QueueUrgent(const char*, const char*, const char*, const char*, uint16_t, AT_Callback);
+uint8_t AT_SendCommand(const char*, const char*, const char*, uint16_t);
+void AT_Poll();
+uint8_t AT_IsIdle();
+void AT_SetURCTable(const Struct_URC*, uint8_t);
+void AT_CaptureNextLine(AT_URCHandler);
+uint8_t AT_IsFinalResponse(const char*);
+void AT_SetTimings(const Struct_AT_Timing*);
+const Struct_AT_Timing* AT_GetTimings();
+uint8_t AT_TimingsChanged();
+
+#endif	//_AT_ENGINE_H_
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_clock.c
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file sets the system clock as per the CLOCK_PROFILE
+  * @Note	 System clock prescaler is written even though the fuse bytes are set for the profile. So F_CPU is
+  *			 correct even if the fuses are not programmed (CKDIV8 is programmed in a fresh chip).
+  ******************************************************************************
+  *
+  *					HOW TO USE
+  * 1. Select CLOCK_PROFILE in wireless_control_config.h
+  * 2. Call CLOCK_Init() at the start of main(), before any peripheral is initialized
+  * 3. Define CLOCK_OSCCAL with the calibrated value, if the internal RC oscillator has to be tuned
+  ******************************************************************************
+  */
+
+/*----------------------------------- Includes -------------------------------*/
+#include "atmega328p_clock.h"
+
+/*---------------------------------- Function and Hooks ----------------------------------*/
+
+/*
+ * @name   	CLOCK_Init()
+ * @brief	This function is to set the system clock prescaler and oscillator calibration for the CLOCK_PROFILE
+ * @param  	None
+ * @note	CLKPR has to be written with in 4 cycles after CLKPCE is set, so the interrupts are disabled while writing
+ * @retval	None
+ */
+void CLOCK_Init()
+{
+	uint8_t sreg = SREG;
+
+	SREG = 0x00;		//Disable the Global interrupt
+	CLKPR = CLOCK_PRESCALER_CHANGE;
+	CLKPR = CLOCK_PRESCALER;
+	SREG = sreg;
+
+#if defined(CLOCK_OSCCAL) && (CLOCK_PROFILE != CLOCK_16MHZ_XTAL)
+	OSCCAL = CLOCK_OSCCAL;		// Internal RC oscillator calibration, so that _delay_ms() and the baud rate are correct
+#endif // CLOCK_OSCCAL
+}
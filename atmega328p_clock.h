@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_clock.h
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file maps the CLOCK_PROFILE to fuse bytes, F_CPU and the system clock prescaler.
+  * @note	 Select the profile in wireless_control_config.h. F_CPU is defined here, so this file has to be included
+  *			 before <util/delay.h>. If F_CPU is passed from the build it must match the profile.
+  ******************************************************************************
+  *
+  * @Reference	Check "System Clock and Clock Options" and "Memory Programming" in the datasheet for fuse bits.
+  *				Baud rate error is calculated the same way as USARTInit() does, in steps of 0.1%.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ATMEGA328P_CLOCK_H				// to avoid the multiple definition!
+#define __ATMEGA328P_CLOCK_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include "wireless_control_config.h"
+
+/* Defines -------------------------------------------------------------------*/
+#if (CLOCK_PROFILE == CLOCK_1MHZ_RC)
+#define CLOCK_F_CPU			1000000UL
+#define CLOCK_LFUSE			0x62		// Internal 8MHz RC, CKDIV8 programmed, 6CK + 64ms start up
+#define CLOCK_PRESCALER		0x03		// CLKPR value for divide by 8
+#elif (CLOCK_PROFILE == CLOCK_8MHZ_RC)
+#define CLOCK_F_CPU			8000000UL
+#define CLOCK_LFUSE			0xE2		// Internal 8MHz RC, CKDIV8 unprogrammed, 6CK + 64ms start up
+#define CLOCK_PRESCALER		0x00		// CLKPR value for divide by 1
+#elif (CLOCK_PROFILE == CLOCK_16MHZ_XTAL)
+#define CLOCK_F_CPU			16000000UL
+#define CLOCK_LFUSE			0xFF		// Low power crystal 8 - 16MHz, CKDIV8 unprogrammed, 16K CK + 65ms start up
+#define CLOCK_PRESCALER		0x00		// CLKPR value for divide by 1
+#else
+#error "Unknown CLOCK_PROFILE, check wireless_control_config.h"
+#endif
+
+#define CLOCK_HFUSE			HFUSE_DEFAULT
+#define CLOCK_EFUSE			EFUSE_DEFAULT
+
+#ifndef F_CPU
+#define F_CPU				CLOCK_F_CPU
+#elif (F_CPU != CLOCK_F_CPU)
+#error "F_CPU passed from the build doesn't match CLOCK_PROFILE"
+#endif
+
+#define CLOCK_PRESCALER_CHANGE	0x80		// CLKPCE bit of CLKPR
+
+/*
+ * Baud rate divisor and error for the profile, same as USARTInit() calculates. Divider is 16 for ASYNCHRONOUS and 8 for DOUBLESPEEDASYNC
+ * CLOCK_BAUD_MODE() gives the mode with the least error, or 0 if the baud rate error is more than CLOCK_MAX_BAUD_ERROR in both modes.
+ */
+#define CLOCK_MAX_BAUD_ERROR	20		// in steps of 0.1%, i.e. 2%
+
+#define CLOCK_UBRR(baud, divider)		((((F_CPU / (divider)) + ((baud) / 2)) / (baud)) - 1)
+#define CLOCK_ACTUAL_BAUD(baud, divider)	(F_CPU / ((divider) * (CLOCK_UBRR(baud, divider) + 1)))
+#define CLOCK_BAUD_ERROR(baud, divider)	\
+		((((CLOCK_ACTUAL_BAUD(baud, divider) > (baud)) ? (CLOCK_ACTUAL_BAUD(baud, divider) - (baud)) : ((baud) - CLOCK_ACTUAL_BAUD(baud, divider))) * 1000UL) / (baud))
+
+#define CLOCK_BAUD_MODE(baud)	\
+		((CLOCK_BAUD_ERROR(baud, 16) <= CLOCK_MAX_BAUD_ERROR) ? 0x04 : ((CLOCK_BAUD_ERROR(baud, 8) <= CLOCK_MAX_BAUD_ERROR) ? 0x03 : 0))
+
+/* Base baud rate of the modem link, should be with in the error for the profile */
+#ifndef USART_BASE_BAUD_RATE
+#define USART_BASE_BAUD_RATE	9600
+#endif // USART_BASE_BAUD_RATE
+
+#if (CLOCK_BAUD_MODE(USART_BASE_BAUD_RATE) == 0)
+#error "USART_BASE_BAUD_RATE has more than 2% error for CLOCK_PROFILE"
+#endif
+
+#define USART_BASE_MODE		((USARTModesType)CLOCK_BAUD_MODE(USART_BASE_BAUD_RATE))
+
+/* exported functions ------------------------------------------------------------------*/
+void CLOCK_Init();
+
+#endif // end of __ATMEGA328P_CLOCK_H
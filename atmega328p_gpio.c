@@ -8,5 +8,5 @@
  *  Volatile is used for ret value and the function because to avoid warnings and compiler should not optimise the code!
  */static volatile uint8_t *(GetSFR_IO_Reg(ports GPIOx, actions action)){
     volatile uint8_t *ret = 0;    switch(GPIOx+action)	{		case 3:		ret = &(PINB); 	    break;		case 4:		ret = &(DDRB); 	    break;		case 5:		ret = &(PORTB); 	break;		case 6:		ret = &(PINC); 	    break;		case 7:		ret = &(DDRC); 	    break;		case 8:		ret = &(PORTC); 	break;		case 9:		ret = &(PIND); 	    break;		case 10:	ret = &(DDRD); 	    break;		case 11:	ret = &(PORTD); 	break;		//defaulf: 			            break;	}
-	return ret;}void GPIO_Write(ports GPIOx, pins pin, uint8_t val){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, WRITE);	if(val != GPIO_PIN_RESET)	{		*GPIO = (*GPIO | pin);	}	else	{		*GPIO = (*GPIO & ~pin);	}}uint8_t GPIO_Read(ports GPIOx, pins pin){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, READ);	return (*GPIO & pin);}void GPIO_Config(ports GPIOx, pins pin, modes mode){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, CONFIG);	if(mode != INPUT)	{		*GPIO = (*GPIO | pin);	}	else	{		*GPIO = (*GPIO & ~pin);		/*		*	once the Pin is configured as input. Internal PULL-UP resister		*	should be activated. Below code does that.		*/		GPIO = GetSFR_IO_Reg(GPIOx, WRITE);		*GPIO = (*GPIO | pin);	}}
+	return ret;}/* *  Read-modify-write of the port is done with the interrupts disabled, as ISRs write the other pins of the *  same port (RTS of USART on PORTD, software UART on PORTB). Else the pin written by the ISR would be lost! */void GPIO_Write(ports GPIOx, pins pin, uint8_t val){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, WRITE);	uint8_t sreg = SREG;	SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;	if(val != GPIO_PIN_RESET)	{		*GPIO = (*GPIO | pin);	}	else	{		*GPIO = (*GPIO & ~pin);	}	SREG = sreg;}uint8_t GPIO_Read(ports GPIOx, pins pin){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, READ);	return (*GPIO & pin);}void GPIO_Config(ports GPIOx, pins pin, modes mode){	volatile uint8_t *GPIO = GetSFR_IO_Reg(GPIOx, CONFIG);	if(mode != INPUT)	{		*GPIO = (*GPIO | pin);	}	else	{		*GPIO = (*GPIO & ~pin);		/*		*	once the Pin is configured as input. Internal PULL-UP resister		*	should be activated. Below code does that.		*/		GPIO = GetSFR_IO_Reg(GPIOx, WRITE);		*GPIO = (*GPIO | pin);	}}
 
@@ -32,6 +32,10 @@
 #define		GPIO_PIN_RESET		0x00
 #define		GPIO_PIN_SET		0x01
 
+#ifndef GLOBAL_INTERRUPT_FLAG
+#define	GLOBAL_INTERRUPT_FLAG	0x80		// I bit of SREG
+#endif // GLOBAL_INTERRUPT_FLAG
+
 /* enums	------------------------------------------------------------------*/
 typedef enum
 {
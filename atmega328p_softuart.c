@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_softuart.c
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file has the transmit only software UART driven by Timer2 compare match interrupt
+  * @Note	 Timer2 runs in CTC mode and interrupts once per bit. The ISR writes the next bit on the pin and loads the
+  * 		 next byte from the transmit ring buffer after the stop bit. Timer interrupt is disabled when nothing is to be sent.
+  * 		 If the ring buffer is full the data is dropped, so that debug trace never slows down the main loop.
+  ******************************************************************************
+  *
+  *					HOW TO USE
+  * 1. Call SOFTUART_Init() once, after the Global interrupt is enabled data will be sent
+  * 2. Call SOFTUART_PutChar() or debugPrint() from printf_code.c to send the data
+  ******************************************************************************
+  */
+
+/*----------------------------------- Includes -------------------------------*/
+#include "atmega328p_softuart.h"
+
+/*---------------------------------- Global Variables ----------------------------------*/
+static volatile uint8_t gBuffer[SOFTUART_BUFFER_SIZE];
+static volatile uint8_t gHead = 0;			// Written only by the producer
+static volatile uint8_t gTail = 0;			// Written only by Timer2 ISR
+
+static volatile uint8_t gActive = 0;		// Set while Timer2 interrupt is sending the data
+static volatile uint8_t gBitIndex = 0;		// 0 - start bit, 1 to 8 - data bits, 9 - stop bit
+static volatile uint8_t gShift = 0;			// Byte being sent
+static uint16_t gDropped = 0;
+
+/*---------------------------------- Function and Hooks ----------------------------------*/
+
+/*
+ * @name   	SOFTUART_Init()
+ * @brief	This function is to configure the pin and Timer2 for the software UART
+ * @param  	None
+ * @retval	None
+ */
+void SOFTUART_Init()
+{
+	GPIO_Config(SOFTUART_PORT, SOFTUART_PIN, OUTPUT);
+	GPIO_Write(SOFTUART_PORT, SOFTUART_PIN, GPIO_PIN_SET);		// Line is idle high
+
+	TIMSK2 = 0x00;
+	TCCR2A = TIMER2_CTC_MODE;
+	TCCR2B = SOFTUART_CLOCK_SELECT;
+	OCR2A = SOFTUART_COMPARE_VALUE;
+
+	gHead = 0;
+	gTail = 0;
+	gActive = 0;
+}
+
+/*
+ * @name   	SOFTUART_IRQHandler()
+ * @brief	This function is a interrupt service routine to handle the Timer2 compare match interrupt
+ * @param  	NONE
+ * @note	One bit is sent in every interrupt. After the stop bit next byte is loaded from the ring buffer,
+ * 			if ring buffer is empty Timer2 interrupt is disabled.
+ * @retval	NONE
+ */
+SOFTUART_IRQHandler()
+{
+	uint8_t tail;
+
+	if(gBitIndex == 0)
+	{
+		GPIO_Write(SOFTUART_PORT, SOFTUART_PIN, GPIO_PIN_RESET);		// Start bit
+	}
+	else if(gBitIndex < 9)
+	{
+		GPIO_Write(SOFTUART_PORT, SOFTUART_PIN, gShift & 0x01);		// LSB first
+		gShift = gShift >> 1;
+	}
+	else
+	{
+		GPIO_Write(SOFTUART_PORT, SOFTUART_PIN, GPIO_PIN_SET);		// Stop bit
+
+		tail = gTail;
+		if(gHead != tail)
+		{
+			gShift = gBuffer[tail & SOFTUART_BUFFER_MASK];
+			gTail = tail + 1;
+			gBitIndex = 0;
+		}
+		else
+		{
+			TIMSK2 = TIMSK2 & ~TIMER2_COMPARE_A_IRQ;
+			gActive = 0;
+		}
+		return;
+	}
+
+	gBitIndex++;
+}
+
+/*
+ * @name   	SOFTUART_WriteChar(uint8_t)
+ * @brief	This function is to queue the charater to the transmit ring buffer
+ * @param  	data - The data to be transmitted!
+ * @retval	0x00	- if data is queued
+ *			0xFF	- if the ring buffer is full and data is dropped
+ * @note	If the Timer2 interrupt is not running, the first byte is loaded and the interrupt is enabled
+ */
+uint8_t SOFTUART_WriteChar(uint8_t data)
+{
+	uint8_t head = gHead;
+	uint8_t tail;
+	uint8_t sreg;
+
+	if((uint8_t)(head - gTail) >= SOFTUART_BUFFER_SIZE)
+	{
+		gDropped++;
+		return 0xFF;
+	}
+
+	gBuffer[head & SOFTUART_BUFFER_MASK] = data;
+	gHead = head + 1;
+
+	//ISR disables itself when the ring buffer is empty, so check and start with the interrupts disabled
+	sreg = SREG;
+	SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+	if(!gActive)
+	{
+		tail = gTail;
+		gShift = gBuffer[tail & SOFTUART_BUFFER_MASK];
+		gTail = tail + 1;
+		gBitIndex = 0;
+		gActive = 1;
+
+		TCNT2 = 0;
+		TIFR2 = TIMER2_COMPARE_A_FLAG;		// Clear the pending compare match by writing 1
+		TIMSK2 = TIMSK2 | TIMER2_COMPARE_A_IRQ;
+	}
+	SREG = sreg;
+
+	return 0x00;
+}
+
+/*
+ * @name   	SOFTUART_PutChar(uint16_t)
+ * @brief	This function is to transmit the charater, same as USART_PutChar() so it can be used as print sink
+ * @param  	data - The data to be transmitted! Only 8 bits are sent
+ * @retval	None
+ */
+void SOFTUART_PutChar(uint16_t data)
+{
+	SOFTUART_WriteChar(data & 0xFF);
+}
+
+/*
+ * @name   	SOFTUART_GetDroppedCount()
+ * @brief	This function is to get the number of bytes dropped as ring buffer was full
+ * @param  	None
+ * @retval	uint16_t - number of bytes dropped
+ */
+uint16_t SOFTUART_GetDroppedCount()
+{
+	return gDropped;
+}
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_softuart.h
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file contains the configuration of transmit only software UART, used for debug trace
+  * @note	 Hardware USART is used by the GSM module, so debug messages are sent on a spare GPIO.
+  *			 Timer2 is used for bit timing, it should not be used by any other module.
+  ******************************************************************************
+  *
+  * @Reference	Frame is 8 data bits, no parity and one stop bit. Line is idle high.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ATMEGA328P_SOFTUART_H				// to avoid the multiple definition!
+#define __ATMEGA328P_SOFTUART_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include "avr/interrupt.h"
+#include "atmega328p_clock.h"
+#include "atmega328p_gpio.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SOFTUART_IRQHandler()		ISR(TIMER2_COMPA_vect)
+
+#ifndef SOFTUART_PORT
+#define SOFTUART_PORT			GPIOB
+#define SOFTUART_PIN			PIN_ZERO		// PB0, not used by any other module
+#endif // SOFTUART_PORT
+
+#ifndef SOFTUART_BAUD_RATE
+ #if (F_CPU >= 8000000UL)
+#define SOFTUART_BAUD_RATE		9600
+ #else
+#define SOFTUART_BAUD_RATE		2400			// Bit time should be long enough for the ISR at 1MHz
+ #endif
+#endif // SOFTUART_BAUD_RATE
+
+#define SOFTUART_PRESCALER		8
+#define SOFTUART_CLOCK_SELECT	0x02			// CS2x bits for clk/8
+#define SOFTUART_COMPARE_VALUE	((((F_CPU / SOFTUART_PRESCALER) + (SOFTUART_BAUD_RATE / 2)) / SOFTUART_BAUD_RATE) - 1)
+
+#if (SOFTUART_COMPARE_VALUE > 255)
+#error "SOFTUART_BAUD_RATE is too low for F_CPU, Timer2 compare value is more than 8 bits"
+#endif
+
+#define SOFTUART_BUFFER_SIZE	64				// Must be power of 2 and not more than 128!
+#define SOFTUART_BUFFER_MASK	(SOFTUART_BUFFER_SIZE - 1)
+
+#if ((SOFTUART_BUFFER_SIZE & SOFTUART_BUFFER_MASK) != 0) || (SOFTUART_BUFFER_SIZE > 128)
+#error "SOFTUART_BUFFER_SIZE must be a power of 2 and not more than 128"
+#endif
+
+#ifndef GLOBAL_INTERRUPT_FLAG
+#define	GLOBAL_INTERRUPT_FLAG	0x80
+#endif // GLOBAL_INTERRUPT_FLAG
+
+#define TIMER2_CTC_MODE			0x02			// WGM21 bit of TCCR2A
+#define TIMER2_COMPARE_A_IRQ	0x02			// OCIE2A bit of TIMSK2
+#define TIMER2_COMPARE_A_FLAG	0x02			// OCF2A bit of TIFR2
+
+/* exported functions ------------------------------------------------------------------*/
+void SOFTUART_Init();
+uint8_t SOFTUART_WriteChar(uint8_t);
+void SOFTUART_PutChar(uint16_t);
+uint16_t SOFTUART_GetDroppedCount();
+
+#endif // end of __ATMEGA328P_SOFTUART_H
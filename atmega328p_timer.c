@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_timer.c
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file has the 1 millisecond system tick using Timer0
+  * @Note	 Tick is 32 bit, it wraps after about 49 days. TIMER_Expired() takes care of the wrap as long as the
+  * 		 deadline is less than 24 days away.
+  ******************************************************************************
+  *
+  *					HOW TO USE
+  * 1. Call TIMER_Init() once, tick runs after the Global interrupt is enabled
+  * 2. deadline = TIMER_GetTicks() + timeout; then check TIMER_Expired(deadline) in the loop instead of _delay_ms()
+  ******************************************************************************
+  */
+
+/*----------------------------------- Includes -------------------------------*/
+#include "atmega328p_timer.h"
+
+/*---------------------------------- Global Variables ----------------------------------*/
+static volatile uint32_t gTicks = 0;
+
+/*---------------------------------- Function and Hooks ----------------------------------*/
+
+/*
+ * @name   	TIMER_Init()
+ * @brief	This function is to configure Timer0 for 1ms compare match interrupt
+ * @param  	None
+ * @retval	None
+ */
+void TIMER_Init()
+{
+	TCCR0A = TIMER0_CTC_MODE;
+	TCCR0B = TIMER_CLOCK_SELECT;
+	OCR0A = TIMER_COMPARE_VALUE;
+	TCNT0 = 0;
+	TIMSK0 = TIMSK0 | TIMER0_COMPARE_A_IRQ;
+}
+
+/*
+ * @name   	TIMER0_IRQHandler()
+ * @brief	This function is a interrupt service routine to handle the Timer0 compare match interrupt
+ * @param  	NONE
+ * @retval	NONE
+ */
+TIMER0_IRQHandler()
+{
+	gTicks++;
+}
+
+/*
+ * @name   	TIMER_GetTicks()
+ * @brief	This function is to get the milliseconds elapsed since TIMER_Init()
+ * @param  	None
+ * @note	Tick is 32 bit, so it is read with the interrupts disabled
+ * @retval	uint32_t - milliseconds
+ */
+uint32_t TIMER_GetTicks()
+{
+	uint32_t ticks;
+	uint8_t sreg = SREG;
+
+	SREG = sreg & ~0x80;		// Disable the Global interrupt
+	ticks = gTicks;
+	SREG = sreg;
+
+	return ticks;
+}
+
+/*
+ * @name   	TIMER_Expired(uint32_t)
+ * @brief	This function is to check whether the deadline is reached
+ * @param  	deadline - tick value calculated from TIMER_GetTicks()
+ * @retval	1 - if the deadline is reached
+ *			0 - otherwise
+ */
+uint8_t TIMER_Expired(uint32_t deadline)
+{
+	return ((int32_t)(TIMER_GetTicks() - deadline) >= 0) ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    atmega328p_timer.h
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file contains the configuration of Timer0 as 1 millisecond system tick
+  * @note	 Timer0 is used for the tick, it should not be used by any other module.
+  ******************************************************************************
+  *
+  * @Reference	Timer0 runs in CTC mode, compare match A interrupt increments the tick.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ATMEGA328P_TIMER_H				// to avoid the multiple definition!
+#define __ATMEGA328P_TIMER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include "avr/interrupt.h"
+#include "atmega328p_clock.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define TIMER0_IRQHandler()		ISR(TIMER0_COMPA_vect)
+
+#if ((F_CPU / 8 / 1000) <= 256)
+#define TIMER_PRESCALER			8
+#define TIMER_CLOCK_SELECT		0x02			// CS0x bits for clk/8
+#else
+#define TIMER_PRESCALER			64
+#define TIMER_CLOCK_SELECT		0x03			// CS0x bits for clk/64
+#endif
+
+#define TIMER_COMPARE_VALUE		((F_CPU / TIMER_PRESCALER / 1000) - 1)
+
+#if (TIMER_COMPARE_VALUE > 255)
+#error "F_CPU is too high for 1ms tick with Timer0"
+#endif
+
+#define TIMER0_CTC_MODE			0x02			// WGM01 bit of TCCR0A
+#define TIMER0_COMPARE_A_IRQ	0x02			// OCIE0A bit of TIMSK0
+
+/* exported functions ------------------------------------------------------------------*/
+void TIMER_Init();
+uint32_t TIMER_GetTicks();
+uint8_t TIMER_Expired(uint32_t);
+
+#endif // end of __ATMEGA328P_TIMER_H
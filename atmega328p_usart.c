@@ -8,14 +8,29 @@
   * @Note	 For Baud rate 0.5 is added so that to get the proper value for UBBR register and the value falls within the error boundry
   * 		 UBBRn = ((Freq / (16 * BaudRate)) + 0.5) - 1	// This is for asynchromous mode!
   * 		       => ((Freq / 16 + baud / 2) / baud - 1)  => So that overflow and underflow has been taken care in code
-  * 		 The Receive IRQ handler will fill the receive buffer gReceived_Data[] untill it is fully filled or enter is pressed.
+  * 		 With USE_FLOW_CONTROL, RTS is deasserted by the RX ISR when the ring buffer crosses USART_RX_HIGH_WATER and asserted
+  * 		 again by the consumer below USART_RX_LOW_WATER. UDRE ISR holds the transmission while modem deasserts CTS,
+  * 		 and CTS pin change interrupt restarts it.
+  * 		 In double speed mode (U2Xx = 1) divider is 8 instead of 16. USART_BaudRateError() gives the error of the generated
+  * 		 baud rate, USART_SetBaudRate() changes the baud rate without disturbing the other settings.
+  * 		 The Receive IRQ handler only copies the received byte into the receive ring buffer gRxBuffer[]. The ring buffer is
+  * 		 single producer (RX ISR) and single consumer (main loop). Head is written only by the ISR and tail only by the
+  * 		 consumer, both are 8 bit so they are read and written atomically without disabling the interrupts.
+  * 		 USART_FillReceiveBuffer() moves the bytes from ring buffer to gGSM_Response untill a line is complete.
+  * 		 Lines are kept one after the other in gGSM_Response, each null terminated, till the buffer is flushed.
+  * 		 USART_GetLines() gives the (offset, length) of each of them, so the lines of a multi-line response
+  * 		 are indexed directly. Blank lines are not kept.
   ******************************************************************************
   *
   *					HOW TO USE
   * 1. Call the initialization function USARTInit() with the USART which is used.
   * 2. If it is interrupt based make sure that USART_EnableInterrupt() is called
   * 3. Call the function USART_PutChar() and/or USART_GetChar() to send or receive data
-  * 4. If the Receive buffer is filled (gReceive_Buffer_Full == 1) either empty the buffer or flush the buffer by called the function
+  * 	USART_PutChar() only queues the data to transmit ring buffer, it is sent by the UDRE ISR. Call
+  * 	USART_FlushTransmitBuffer() if the data has to be on the wire before going ahead
+  * 4. Call USART_FillReceiveBuffer() from the main loop to assemble the received line in gGSM_Response or USART_ReadChar() to
+  * 	read the received bytes one by one without blocking
+  * 5. If the Receive buffer is filled (gReceive_Buffer_Full == 1) either empty the buffer or flush the buffer by called the function
   * 	USART_ClearReceiveBuffer() or USART_FlushReceiveBuffer()
   ******************************************************************************
   */
@@ -33,8 +48,31 @@ volatile static uint8_t *DataT;
 //volatile static uint8_t *Data;
 
 /*---------------------------------- Global Variables ----------------------------------*/
-static uint16_t gReceived_Data[128];
 static uint8_t gIndex = 0;
+static uint8_t gLineStart = 0;			// Start of the line being assembled in gGSM_Response
+static uint8_t gLastLineStart = 0;		// Start of the last completed line in gGSM_Response
+static USART_LineType gLines[USART_MAX_LINES];	// Lines kept in gGSM_Response
+static uint8_t gLineCount = 0;
+
+static volatile uint8_t gRxBuffer[USART_RX_BUFFER_SIZE];
+static volatile uint8_t gRxHead = 0;		// Written only by RX ISR
+static volatile uint8_t gRxTail = 0;		// Written only by the consumer
+
+static volatile uint8_t gTxBuffer[USART_TX_BUFFER_SIZE];
+static volatile uint8_t gTxHead = 0;		// Written only by the producer
+static volatile uint8_t gTxTail = 0;		// Written only by UDRE ISR, or by the producer with the interrupts disabled
+static uint8_t gTxStarted = 0;			// Set once a byte is written to data register, so that TXC flag is valid
+
+static volatile USART_StatsType gStats;	// Link health counters, updated in RX ISR and USART_FillReceiveBuffer()
+static uint8_t gLineTruncated = 0;		// Truncated line is counted only once
+
+#if (USE_FLOW_CONTROL != 0)
+static volatile uint8_t gFlowControl = 0;		// Set when RTS/CTS is enabled
+static volatile uint8_t gRtsDeasserted = 0;		// Set by RX ISR when the ring buffer is crossed high water mark
+#endif // USE_FLOW_CONTROL
+
+static uint32_t gBaudRate;				// Baud rate and mode which are in use
+static USARTModesType gMode;
 
 /*---------------------------------- Function and Hooks ----------------------------------*/
 
@@ -71,6 +109,49 @@ void USARTRegInit(USART_StructureType USARTConfig)
     }
 }
 
+/*
+ * @name   	USART_BaudRateRegValue(uint32_t, USARTModesType)
+ * @brief	This function is to calculate the UBRRx register value for the baud rate
+ * @param  	baudRate - required baud rate
+ *			mode	 - USART mode, which decides the divider
+ * @retval	uint32_t - UBRRx value. Value will be more than 0x0FFF if baud rate cannot be generated
+ */
+static uint32_t USART_BaudRateRegValue(uint32_t baudRate, USARTModesType mode)
+{
+	uint32_t value;
+
+	value = (((F_CPU / (1UL << mode)) + (baudRate / 2)) / baudRate);
+	if(value > 0)
+		value = value - 1;
+	else
+		value = 0xFFFF;		// Baud rate is more than F_CPU / divider
+
+	return value;
+}
+
+/*
+ * @name   	USART_BaudRateError(uint32_t, USARTModesType)
+ * @brief	This function is to calculate the error of generated baud rate against the required baud rate for F_CPU
+ * @param  	baudRate - required baud rate
+ *			mode	 - USART mode, which decides the divider
+ * @retval	uint16_t - error in steps of 0.1%. USART_INVALID_BAUD_ERROR if baud rate cannot be generated
+ */
+uint16_t USART_BaudRateError(uint32_t baudRate, USARTModesType mode)
+{
+	uint32_t value;
+	uint32_t actualBaudRate;
+	uint32_t difference;
+
+	value = USART_BaudRateRegValue(baudRate, mode);
+	if(value > 0x0FFF)
+		return USART_INVALID_BAUD_ERROR;
+
+	actualBaudRate = F_CPU / ((1UL << mode) * (value + 1));
+	difference = (actualBaudRate > baudRate) ? (actualBaudRate - baudRate) : (baudRate - actualBaudRate);
+
+	return (uint16_t)((difference * 1000UL) / baudRate);
+}
+
 /*
  * @name   	USARTInit(uint8_t, USART_StructureType)
  * @brief	This function is to configure USARTx based on the given inputs
@@ -82,7 +163,15 @@ void USARTInit(USART_StructureType USARTConfig)
 {
 	uint16_t BaudRateRegValue; // The register vlaue to be given in UBRRx register!
 
+    if(RegA != 0)
+        USART_FlushTransmitBuffer();	// USART is already initialized, let the queued data go out with old settings!
+
     gReceive_Buffer_Full = 0;
+    gRxHead = 0;
+    gRxTail = 0;
+    gTxHead = 0;
+    gTxTail = 0;
+    gTxStarted = 0;
     USARTRegInit(USARTConfig);
 
 	//Initialize the USART Control and Status Registers to 0
@@ -94,15 +183,21 @@ void USARTInit(USART_StructureType USARTConfig)
 
 	//Now with the given value of the structure USART_StructureType configure the USART
 	//BaudRateRegValue = (((F_CPU / BaudRateDivider + USARTConfig.USART_BaudRate / 2) / USARTConfig.USART_BaudRate) - 1);
-	BaudRateRegValue = ((((F_CPU / (1 << USARTConfig.USART_Modes)) + (USARTConfig.USART_BaudRate / 2)) / USARTConfig.USART_BaudRate) - 1);
+	BaudRateRegValue = USART_BaudRateRegValue(USARTConfig.USART_BaudRate, USARTConfig.USART_Modes);
 	*BRRH = (BaudRateRegValue >> 8) & 0xFF;
 	*BRRL = BaudRateRegValue & 0xFF;
+	gBaudRate = USARTConfig.USART_BaudRate;
+	gMode = USARTConfig.USART_Modes;
 
 	/*Needs to be changed in SPI driver for Master SPI mode*/
 	if(USARTConfig.USART_Modes != DOUBLESPEEDASYNC)
 	{
 		*RegC = *RegC | (USARTConfig.USART_Modes << 6);   // To select the USART mode in UCSRxC register!
 	}
+	else
+	{
+		*RegA = DOUBLE_SPEED_FLAG;	// Double speed is Asynchronous mode with U2Xx bit set
+	}
 
 	// Based on the type of USART communication enable the Tx or RX or Both bits!
 	*RegB = *RegB | USARTConfig.USART_Communication;
@@ -118,21 +213,268 @@ void USARTInit(USART_StructureType USARTConfig)
 	*RegC = *RegC | USARTConfig.USART_Parity;
 }
 
+/*
+ * @name   	USART_SetBaudRate(uint32_t, USARTModesType)
+ * @brief	This function is to change the baud rate of already initialized USART
+ * @param  	baudRate - new baud rate
+ *			mode	 - ASYNCHRONOUS or DOUBLESPEEDASYNC
+ * @retval	0x00	- if baud rate is changed
+ *			0xFF	- if the baud rate error is more than USART_MAX_BAUD_ERROR, settings are not changed
+ * @note	Queued data is transmitted with the old baud rate first. Data in receive ring buffer is dropped as it
+ *			may be received while switching. Other settings and interrupts are not disturbed.
+ */
+uint8_t USART_SetBaudRate(uint32_t baudRate, USARTModesType mode)
+{
+	uint16_t BaudRateRegValue;
+
+	if((mode == SYNCRONOUS) || (USART_BaudRateError(baudRate, mode) > USART_MAX_BAUD_ERROR))
+		return 0xFF;
+
+	USART_FlushTransmitBuffer();
+
+	BaudRateRegValue = USART_BaudRateRegValue(baudRate, mode);
+	if(mode == DOUBLESPEEDASYNC)
+		*RegA = (*RegA & 0x01) | DOUBLE_SPEED_FLAG;		// FE/DOR/UPE must be written 0!
+	else
+		*RegA = (*RegA & 0x01);
+	*BRRH = (BaudRateRegValue >> 8) & 0xFF;
+	*BRRL = BaudRateRegValue & 0xFF;	// Writing UBRRxL updates the baud rate prescaler immediately
+
+	gBaudRate = baudRate;
+	gMode = mode;
+
+	gRxTail = gRxHead;
+	USART_FlushReceiveBuffer();
+
+	return 0x00;
+}
+
+/*
+ * @name   	USART_GetBaudRate()
+ * @brief	This function is to get the baud rate in use
+ * @param  	None
+ * @retval	uint32_t - baud rate
+ */
+uint32_t USART_GetBaudRate()
+{
+	return gBaudRate;
+}
+
+/*
+ * @name   	USART_GetMode()
+ * @brief	This function is to get the USART mode in use
+ * @param  	None
+ * @retval	USARTModesType - mode
+ */
+USARTModesType USART_GetMode()
+{
+	return gMode;
+}
+
+/*
+ * @name   	USART_TransmitNext()
+ * @brief	This function moves the next byte from transmit ring buffer to data register
+ * @param  	None
+ * @note	Data register must be empty before calling this function. Called from UDRE ISR, or from the producer when the
+ * 			interrupts are disabled. Once the ring buffer is empty data register empty interrupt is disabled.
+ * @retval	None
+ */
+static void USART_TransmitNext()
+{
+	uint8_t tail = gTxTail;
+
+#if (USE_FLOW_CONTROL != 0)
+	if(gFlowControl && GPIO_Read(USART_CTS_PORT, USART_CTS_PIN))
+	{
+		*RegB = *RegB & ~DATA_REGISTER_EMPTY_IRQ;		// Modem cannot receive, CTS pin change interrupt will restart
+		return;
+	}
+#endif // USE_FLOW_CONTROL
+
+	if(gTxHead != tail)
+	{
+		*RegA = (*RegA & 0x03) | TRANSMIT_COMPLETE_FLAG;	// Clear TXC by writing 1, FE/DOR/UPE must be written 0!
+		*DataT = gTxBuffer[tail & USART_TX_BUFFER_MASK];
+		gTxTail = ++tail;
+		gTxStarted = 1;
+	}
+
+	if(gTxHead == tail)
+		*RegB = *RegB & ~DATA_REGISTER_EMPTY_IRQ;
+}
+
+/*
+ * @name   	USARTUDRE_IRQHandler()
+ * @brief	This function is a interrupt service routine to handle the USART data register empty interrupt
+ * @param  	NONE
+ * @note	Sends the next byte from the transmit ring buffer
+ * @retval	NONE
+ */
+USARTUDRE_IRQHandler()
+{
+	USART_TransmitNext();
+}
+
+#if (USE_FLOW_CONTROL != 0)
+/*
+ * @name   	USARTCTS_IRQHandler()
+ * @brief	This function is a interrupt service routine to handle the pin change interrupt of CTS pin
+ * @param  	NONE
+ * @note	When modem asserts CTS and data is waiting in the transmit ring buffer, UDRE interrupt is enabled again
+ * @retval	NONE
+ */
+USARTCTS_IRQHandler()
+{
+	if(gFlowControl && !GPIO_Read(USART_CTS_PORT, USART_CTS_PIN) && (gTxHead != gTxTail))
+		*RegB = *RegB | DATA_REGISTER_EMPTY_IRQ;
+}
+
+/*
+ * @name   	USART_EnableFlowControl(uint8_t)
+ * @brief	This function is to enable or disable RTS/CTS hardware flow control
+ * @param  	enable - 1 to enable, 0 to disable
+ * @note	RTS is asserted (low) when enabled. Modem has to be configured for hardware flow control (AT+IFC=2,2)
+ *			and CTS pin must be connected, else the transmission will be on hold forever.
+ * @retval	NONE
+ */
+void USART_EnableFlowControl(uint8_t enable)
+{
+	uint8_t sreg;
+
+	if(enable)
+	{
+		GPIO_Config(USART_RTS_PORT, USART_RTS_PIN, OUTPUT);
+		GPIO_Write(USART_RTS_PORT, USART_RTS_PIN, GPIO_PIN_RESET);
+		GPIO_Config(USART_CTS_PORT, USART_CTS_PIN, INPUT);
+
+		gRtsDeasserted = 0;
+		gFlowControl = 1;
+		USART_CTS_PCMSK = USART_CTS_PCMSK | USART_CTS_PIN;
+		PCICR = PCICR | USART_CTS_PCIE;
+	}
+	else
+	{
+		gFlowControl = 0;
+		USART_CTS_PCMSK = USART_CTS_PCMSK & ~USART_CTS_PIN;
+		GPIO_Config(USART_RTS_PORT, USART_RTS_PIN, INPUT);
+	}
+
+	//Restart the transmission if it was on hold
+	sreg = SREG;
+	SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+	if(gTxHead != gTxTail)
+		*RegB = *RegB | DATA_REGISTER_EMPTY_IRQ;
+	SREG = sreg;
+}
+#endif // USE_FLOW_CONTROL
+
+/*
+ * @name   	USART_WriteChar(uint8_t)
+ * @brief	This function is to queue the charater to the transmit ring buffer without blocking
+ * @param  	data - The data to be transmitted!
+ * @retval	0x00	- if data is queued
+ *			0xFF	- if the transmit ring buffer is full
+ */
+uint8_t USART_WriteChar(uint8_t data)
+{
+	uint8_t retVal = 0xFF;
+	uint8_t head = gTxHead;
+	uint8_t sreg;
+
+	if((uint8_t)(head - gTxTail) < USART_TX_BUFFER_SIZE)
+	{
+		gTxBuffer[head & USART_TX_BUFFER_MASK] = data;
+		gTxHead = head + 1;
+
+		//UCSRxB is modified by the ISR also, so update it with interrupts disabled
+		sreg = SREG;
+		SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+		*RegB = *RegB | DATA_REGISTER_EMPTY_IRQ;
+		SREG = sreg;
+
+		retVal = 0x00;
+	}
+
+	return retVal;
+}
+
 /*
  * @name   	USART_PutChar(uint16_t)
  * @brief	This function is to transmit the charater
  * @param  	data - The data to be transmitted!
+ * @note	Data is queued to the transmit ring buffer and this function returns at once. It waits only when the ring buffer is full.
+ * 			If 9th bit has to be transmitted, queued data is flushed and the data is transmitted directly.
  * @retval	None
  */
 void USART_PutChar(uint16_t data)
 {
-	while(!(*RegA & DATA_REGISTER_EMPTY_FLAG))
-		; //As the Tansmit buffer is not empty wait until the Transmit buffer is empty then copy the data to data register to transmit!
-
-	//If there are 9 bits to transmit
 	if(data & 0x0100)
+	{
+		USART_FlushTransmitBuffer();
+
+		while(!(*RegA & DATA_REGISTER_EMPTY_FLAG))
+			; //As the Tansmit buffer is not empty wait until the Transmit buffer is empty then copy the data to data register to transmit!
+
 		*RegB = *RegB | 0x01;
-	*DataT = data & 0xFF;
+		*DataT = data & 0xFF;
+		return;
+	}
+
+	while(USART_WriteChar(data & 0xFF))
+	{
+		//Ring buffer is full. If the interrupts are disabled ISR will never run, so send the oldest byte from here!
+		if(!(SREG & GLOBAL_INTERRUPT_FLAG) && (*RegA & DATA_REGISTER_EMPTY_FLAG))
+			USART_TransmitNext();
+	}
+}
+
+/*
+ * @name   	USART_FlushTransmitBuffer()
+ * @brief	This function waits untill all the queued data is transmitted
+ * @param  	None
+ * @note	Returns only after the last byte is completely shifted out. Call it before changing the USART settings or
+ * 			when the timing of the next action depends on the data being sent.
+ * 			With flow control, if the modem holds CTS for USART_CTS_TIMEOUT the queued data is dropped and counted.
+ * @retval	None
+ */
+void USART_FlushTransmitBuffer()
+{
+#if (USE_FLOW_CONTROL != 0)
+	uint16_t held = 0;		// Tenths of milliseconds CTS is held by the modem
+	uint8_t sreg;
+#endif // USE_FLOW_CONTROL
+
+	while(gTxHead != gTxTail)
+	{
+#if (USE_FLOW_CONTROL != 0)
+		if(gFlowControl && GPIO_Read(USART_CTS_PORT, USART_CTS_PIN))
+		{
+			if(held >= (USART_CTS_TIMEOUT * 10))
+			{
+				sreg = SREG;
+				SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+				*RegB = *RegB & ~DATA_REGISTER_EMPTY_IRQ;
+				gTxTail = gTxHead;
+				gStats.USART_CtsTimeouts++;
+				SREG = sreg;
+				break;
+			}
+			_delay_us(100);
+			held++;
+			continue;
+		}
+		held = 0;
+#endif // USE_FLOW_CONTROL
+
+		if(!(SREG & GLOBAL_INTERRUPT_FLAG) && (*RegA & DATA_REGISTER_EMPTY_FLAG))
+			USART_TransmitNext();
+	}
+
+	if(gTxStarted)
+	{
+		while(!(*RegA & TRANSMIT_COMPLETE_FLAG))
+			;
+	}
 }
 
 /*
@@ -165,71 +507,267 @@ void USART_EnableInterrupt(USARTCommunicationType irq_enable)
 
 /*
  * @name   	USARTRX_IRQHandler()
- * @brief	This function is a interrupt service routine to handle the USART1 interrupt
+ * @brief	This function is a interrupt service routine to handle the USART receive interrupt
  * @param  	NONE
- * @note	In this function the received data will be copied to a buffer gReceived_Data. After 127 data being received the buffer will
- * 			start filling again only after buffer is emptied!
- * 			If the Enter Key is pressed, the gReceive_Buffer_Full flag will be set, Buffer needs to be emptied for new data to be received.
+ * @note	In this function the received data will be copied to the receive ring buffer gRxBuffer.
+ * 			If the ring buffer is full the received data will be dropped, so consumer has to read the ring buffer in time!
+ * 			Only 8 data bits are stored, 9th bit is not supported in the interrupt mode.
+ * 			Error flags are valid only till the data register is read, so they are read and counted first.
  * @retval	NONE
  */
 USARTRX_IRQHandler()
 {
-	//static uint8_t countCR = 0;
-	//static uint8_t countLF = 0;
-	uint16_t ch;
-	ch = USART_GetChar();
+	uint8_t status = *RegA;
+	uint8_t data = *DataR;
+	uint8_t head = gRxHead;
+	uint8_t count;
 
-    /*if(countCR != 2)
+	if(status & (FRAME_ERROR_FLAG | DATA_OVERRUN_FLAG | PARITY_ERROR_FLAG))
 	{
-	    gGSM_Response[gIndex] = ch;
-        gIndex++;
-        if(ch == '\n')
-            countCR++;
+		if(status & DATA_OVERRUN_FLAG)
+			gStats.USART_OverrunErrors++;
+		if(status & FRAME_ERROR_FLAG)
+			gStats.USART_FramingErrors++;
+		if(status & PARITY_ERROR_FLAG)
+			gStats.USART_ParityErrors++;
 	}
-	else
-    {
-        gGSM_Response[gIndex] = '\0';
-        countCR = 0;
-        gReceive_Buffer_Full = 1;
-    }*/
 
-	if(ch != '\n' && (gIndex < (BUFFER_LENGTH - 1)))		// LF - New line Feed character will be received only once!
+	count = (uint8_t)(head - gRxTail);
+	if(count < USART_RX_BUFFER_SIZE)
 	{
-		if(ch != '\r')
+		gRxBuffer[head & USART_RX_BUFFER_MASK] = data;
+		gRxHead = head + 1;
+
+		if(count >= gStats.USART_RxHighWater)
+			gStats.USART_RxHighWater = count + 1;
+
+#if (USE_FLOW_CONTROL != 0)
+		if(gFlowControl && ((count + 1) >= USART_RX_HIGH_WATER) && !gRtsDeasserted)
 		{
-			gGSM_Response[gIndex] = ch;
-			gIndex++;
-			if(ch == 0x3E)
-            {
-                gGSM_Response[gIndex] = '\0';
-                gReceive_Buffer_Full = 1;
-            }
+			GPIO_Write(USART_RTS_PORT, USART_RTS_PIN, GPIO_PIN_SET);	// Ask modem to stop sending
+			gRtsDeasserted = 1;
 		}
+#endif // USE_FLOW_CONTROL
 	}
 	else
+		gStats.USART_DroppedBytes++;
+}
+
+/*
+ * @name   	USART_ReadChar(uint8_t*)
+ * @brief	This function is to read one byte from the receive ring buffer without blocking
+ * @param  	data - the received byte will be copied here
+ * @retval	0x00	- if a byte is read
+ *			0xFF	- if the receive ring buffer is empty
+ */
+uint8_t USART_ReadChar(uint8_t *data)
+{
+	uint8_t retVal = 0xFF;
+	uint8_t tail = gRxTail;
+
+	if(gRxHead != tail)
 	{
-        //if(countCR != 0)
-        //{
-            gGSM_Response[gIndex] = '\0';
-            gReceive_Buffer_Full = 1;
-            //countCR = 0;
-        //}
-        //else if(ch == '\n')
-            //countCR++;
+		*data = gRxBuffer[tail & USART_RX_BUFFER_MASK];
+		gRxTail = tail + 1;		// Release the slot only after the data is copied!
+		retVal = 0x00;
+
+#if (USE_FLOW_CONTROL != 0)
+		if(gRtsDeasserted && ((uint8_t)(gRxHead - gRxTail) <= USART_RX_LOW_WATER))
+		{
+			gRtsDeasserted = 0;
+			GPIO_Write(USART_RTS_PORT, USART_RTS_PIN, GPIO_PIN_RESET);	// Modem can send again
+		}
+#endif // USE_FLOW_CONTROL
 	}
-	/*uint16_t ch;
-	ch = USART_GetChar();
 
-	if((gIndex < 127) && (ch != 0x0D) && (gReceive_Buffer_Full == 0))
+	return retVal;
+}
+
+/*
+ * @name   	USART_ReceiveCount()
+ * @brief	This function is to get the number of bytes waiting in the receive ring buffer
+ * @param  	None
+ * @retval	uint8_t - number of bytes which are yet to be read
+ */
+uint8_t USART_ReceiveCount()
+{
+	return (uint8_t)(gRxHead - gRxTail);
+}
+
+/*
+ * @name   	USART_FillReceiveBuffer()
+ * @brief	This function moves the received bytes from ring buffer to gGSM_Response
+ * @param  	None
+ * @note	Copying stops once a line is complete, the bytes received after that are left in the ring buffer.
+ * 			So calling this function again will add the next line to gGSM_Response untill buffer is flushed!
+ * 			Each line is null terminated and its descriptor is added to the lines given by USART_GetLines().
+ * 			Line is complete when LF - New line Feed character or '>' is received. CR is ignored.
+ * 			Line which does not fit in the buffer is dropped and its descriptor has length 0. Lines before it are dropped
+ * 			as well if less than USART_LINE_RESERVE bytes are left, so that the final result code is always received.
+ * 			gReceive_Buffer_Full is set once a line is complete and USART_GetLastLine() gives that line.
+ * @retval	0x01	- if a line is completed in this call
+ *			0x00	- otherwise
+ */
+uint8_t USART_FillReceiveBuffer()
+{
+	uint8_t ch;
+	uint8_t i;
+	uint8_t lineComplete = 0x00;
+
+	while((!lineComplete) && (!USART_ReadChar(&ch)))
 	{
-		gReceived_Data[gIndex] = ch;
-		gIndex++;
+		if(ch == '\n')		// LF - New line Feed character will be received only once!
+		{
+			lineComplete = 0x01;
+		}
+		else if(ch != '\r')
+		{
+			if(gIndex < (BUFFER_LENGTH - 1))
+			{
+				gGSM_Response[gIndex] = ch;
+				gIndex++;
+			}
+			else
+			{
+				if(!gLineTruncated)
+					gStats.USART_TruncatedLines++;
+				gLineTruncated = 1;
+			}
+
+			if(ch == 0x3E)
+				lineComplete = 0x01;
+		}
 	}
-	else
+
+	if(lineComplete)
 	{
+		if(gLineTruncated)
+		{
+			//Line did not fit, it is dropped. Its descriptor is kept with length 0
+			gIndex = gLineStart;
+			if(gLineCount < USART_MAX_LINES)
+			{
+				gLines[gLineCount].offset = BUFFER_LENGTH - 1;		// Always null character here
+				gLines[gLineCount].length = 0;
+				gLineCount++;
+			}
+
+			//Lines before it are also dropped till there is space for the final response
+			i = gLineCount;
+			while(((BUFFER_LENGTH - 1 - gIndex) < USART_LINE_RESERVE) && (i != 0))
+			{
+				i--;
+				if(gLines[i].length != 0)
+				{
+					gIndex = gLines[i].offset;
+					gLines[i].offset = BUFFER_LENGTH - 1;
+					gLines[i].length = 0;
+				}
+			}
+			gLineStart = gIndex;
+			gLineTruncated = 0;
+		}
+
+		gGSM_Response[gIndex] = '\0';
+		gLastLineStart = gLineStart;
+
+		//Blank line is overwritten by the next line
+		if((gIndex != gLineStart) && (gLineCount < USART_MAX_LINES))
+		{
+			gLines[gLineCount].offset = gLineStart;
+			gLines[gLineCount].length = gIndex - gLineStart;
+			gLineCount++;
+
+			if(gIndex < (BUFFER_LENGTH - 1))
+				gIndex++;		// Keep the null character
+		}
+		gLineStart = gIndex;		// Next line is appended here
 		gReceive_Buffer_Full = 1;
-		gGSM_Response[gIndex] = '\0';	//For GSM Module
-	}*/
+	}
+
+	return lineComplete;
+}
+
+/*
+ * @name   	USART_GetLastLine()
+ * @brief	This function is to get the last line completed by USART_FillReceiveBuffer()
+ * @param  	None
+ * @note	Valid only till the next call of USART_FillReceiveBuffer() or USART_FlushReceiveBuffer()
+ * @retval	uint8_t* - null terminated line in gGSM_Response
+ */
+uint8_t* USART_GetLastLine()
+{
+	return &gGSM_Response[gLastLineStart];
+}
+
+/*
+ * @name   	USART_DiscardLastLine()
+ * @brief	This function is to drop the last line completed by USART_FillReceiveBuffer() from gGSM_Response
+ * @param  	None
+ * @note	Next line is assembled in its place. Lines before it are kept.
+ * 			Used to take the unsolicited result codes out of the response of a running AT command.
+ * @retval	None
+ */
+void USART_DiscardLastLine()
+{
+	if((gLineCount != 0) && (gLines[gLineCount - 1].offset == gLastLineStart))
+		gLineCount--;
+
+	gIndex = gLastLineStart;
+	gLineStart = gLastLineStart;
+	gGSM_Response[gIndex] = '\0';
+}
+
+/*
+ * @name   	USART_GetLines(uint8_t*)
+ * @brief	This function is to get the lines collected in gGSM_Response since the last flush
+ * @param  	count - number of lines will be written here
+ * @note	Line i is at &gGSM_Response[lines[i].offset] and is null terminated.
+ * 			Lines after USART_MAX_LINES are not described, USART_GetLastLine() still gives them.
+ * 			Valid only till the next call of USART_FlushReceiveBuffer()
+ * @retval	USART_LineType* - array of line descriptors
+ */
+const USART_LineType* USART_GetLines(uint8_t *count)
+{
+	*count = gLineCount;
+	return gLines;
+}
+
+/*
+ * @name   	USART_GetStats(USART_StatsType*)
+ * @brief	This function is to read the link health counters
+ * @param  	stats - counters will be copied here
+ * @note	Counters are updated by the RX ISR, so they are copied with the interrupts disabled
+ * @retval	None
+ */
+void USART_GetStats(USART_StatsType *stats)
+{
+	uint8_t sreg = SREG;
+
+	SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+	*stats = *((USART_StatsType*)&gStats);
+	SREG = sreg;
+}
+
+/*
+ * @name   	USART_ClearStats()
+ * @brief	This function is to reset the link health counters
+ * @param  	None
+ * @retval	None
+ */
+void USART_ClearStats()
+{
+	uint8_t sreg = SREG;
+
+	SREG = sreg & ~GLOBAL_INTERRUPT_FLAG;
+	gStats.USART_OverrunErrors = 0;
+	gStats.USART_FramingErrors = 0;
+	gStats.USART_ParityErrors = 0;
+	gStats.USART_DroppedBytes = 0;
+	gStats.USART_TruncatedLines = 0;
+	gStats.USART_CtsTimeouts = 0;
+	gStats.USART_RxHighWater = 0;
+	SREG = sreg;
 }
 
 /*
@@ -247,11 +785,15 @@ void USART_ClearReceiveBuffer()
 
 		for(i = 0; i<gIndex; i++)
 		{
-			USART_PutChar(gReceived_Data[i]);
+			if(gGSM_Response[i] != '\0')		// Lines are null terminated
+				USART_PutChar(gGSM_Response[i]);
 		}
 
 		gReceive_Buffer_Full = 0;	//Once the buffer is emptied the flag and the index should be reset!
 		gIndex = 0;
+		gLineStart = 0;
+		gLastLineStart = 0;
+		gLineCount = 0;
 	}
 }
 
@@ -260,12 +802,17 @@ void USART_ClearReceiveBuffer()
  * @brief	This function is to flush the receive buffer.
  * @param  	None
  * @note	This function can be called when receive buffer needs to be flushed.
+ * 			Only the assembled line is dropped, bytes waiting in the ring buffer are kept for the next line!
  * @retval	NONE
  */
 void USART_FlushReceiveBuffer()
 {
 	gReceive_Buffer_Full = 0;		// reset the receive complete flag and the index for receive buffer!
 	gIndex = 0;
+	gLineStart = 0;
+	gLastLineStart = 0;
+	gLineCount = 0;
+	gLineTruncated = 0;
 }
 /*
  * Function to Check for the parity, and Parity bit after the data bits!
@@ -19,6 +19,12 @@
 /* Includes ------------------------------------------------------------------*/
 #include <avr/io.h>
 #include "avr/interrupt.h"
+#include "atmega328p_clock.h"
+#include "wireless_control_config.h"
+ #if(USE_FLOW_CONTROL != 0)
+#include "atmega328p_gpio.h"
+#include <util/delay.h>
+ #endif // USE_FLOW_CONTROL
 #include "stdio.h"
 #include "stdarg.h"
 #include "stdlib.h"
@@ -28,12 +34,54 @@
 #define RECEIVE_COMPLETE_FLAG		0x80
 #define TRANSMIT_COMPLETE_FLAG		0x40
 #define DATA_REGISTER_EMPTY_FLAG	0x20
+#define FRAME_ERROR_FLAG			0x10
+#define DATA_OVERRUN_FLAG			0x08
+#define PARITY_ERROR_FLAG			0x04
+
+#define DOUBLE_SPEED_FLAG			0x02		// U2Xx bit of UCSRxA
 
 #define	GLOBAL_INTERRUPT_FLAG		0x80
 
+#define USART_MAX_BAUD_ERROR		CLOCK_MAX_BAUD_ERROR	// Maximum allowed baud rate error in steps of 0.1%, i.e. 2%
+#define USART_INVALID_BAUD_ERROR	0xFFFF		// Baud rate cannot be generated from F_CPU in the given mode
+
 #define USARTRX_IRQHandler()		ISR(USART_RX_vect)
+#define USARTUDRE_IRQHandler()		ISR(USART_UDRE_vect)
+
+#define DATA_REGISTER_EMPTY_IRQ		0x20		// UDRIEx bit of UCSRxB
+
+#define	BUFFER_LENGTH	160		// Holds the response of AT+CMGR with a command message, header + 80 characters + OK. Longer lines are dropped. Not more than 255!
+#define USART_MAX_LINES	8		// Maximum lines of a response with the line descriptors
+#define USART_LINE_RESERVE	16		// Space kept for the final result code when a line does not fit
+
+#define USART_RX_BUFFER_SIZE	64		// Size of the receive ring buffer filled by the RX ISR. Must be power of 2 and not more than 128!
+#define USART_RX_BUFFER_MASK	(USART_RX_BUFFER_SIZE - 1)
+
+#if ((USART_RX_BUFFER_SIZE & USART_RX_BUFFER_MASK) != 0) || (USART_RX_BUFFER_SIZE > 128)
+#error "USART_RX_BUFFER_SIZE must be a power of 2 and not more than 128"
+#endif
+
+#define USART_TX_BUFFER_SIZE	32		// Size of the transmit ring buffer drained by the UDRE ISR. Must be power of 2 and not more than 128!
+#define USART_TX_BUFFER_MASK	(USART_TX_BUFFER_SIZE - 1)
+
+#if ((USART_TX_BUFFER_SIZE & USART_TX_BUFFER_MASK) != 0) || (USART_TX_BUFFER_SIZE > 128)
+#error "USART_TX_BUFFER_SIZE must be a power of 2 and not more than 128"
+#endif
 
-#define	BUFFER_LENGTH	128
+#if (USE_FLOW_CONTROL != 0)
+#define USARTCTS_IRQHandler()		ISR(PCINT2_vect)
+
+#define USART_RTS_PORT			GPIOD
+#define USART_RTS_PIN			PIN_FOUR		// PD4 output, low when receive ring buffer has space
+#define USART_CTS_PORT			GPIOD
+#define USART_CTS_PIN			PIN_FIVE		// PD5 input (PCINT21), modem drives it low when it can receive
+#define USART_CTS_PCMSK			PCMSK2
+#define USART_CTS_PCIE			0x04			// PCIE2 bit of PCICR
+
+#define USART_RX_HIGH_WATER		(USART_RX_BUFFER_SIZE - 24)		// RTS is deasserted here, modem may send few more bytes
+#define USART_RX_LOW_WATER		(USART_RX_BUFFER_SIZE / 4)		// RTS is asserted again here
+#define USART_CTS_TIMEOUT		1000	// Milliseconds USART_FlushTransmitBuffer() waits while the modem holds CTS
+#endif // USE_FLOW_CONTROL
 
 volatile uint8_t	gReceive_Buffer_Full;	//Developer has to make sure to read the buffer once the receive buffer is Full! and reset the flag after reading the buffer
 uint8_t	gGSM_Response[BUFFER_LENGTH];	//For GSM Module
@@ -85,6 +133,23 @@ typedef struct
 	USARTCommunicationType	USART_Communication;
 }USART_StructureType;
 
+typedef struct
+{
+	uint16_t	USART_OverrunErrors;	// Data overrun, byte lost in the hardware as RX ISR was not served in time
+	uint16_t	USART_FramingErrors;	// Stop bit was not received, mostly baud rate mismatch
+	uint16_t	USART_ParityErrors;		// Parity check failed
+	uint16_t	USART_DroppedBytes;		// Byte lost as the receive ring buffer was full
+	uint16_t	USART_TruncatedLines;	// Line did not fit in BUFFER_LENGTH
+	uint16_t	USART_CtsTimeouts;		// Queued data dropped as the modem held CTS for USART_CTS_TIMEOUT
+	uint8_t		USART_RxHighWater;		// Maximum bytes waiting in the receive ring buffer
+}USART_StatsType;
+
+typedef struct
+{
+	uint8_t		offset;		// Start of the line in gGSM_Response, line is null terminated
+	uint8_t		length;		// Length of the line without the null character, 0 if the line is dropped as it did not fit
+}USART_LineType;
+
 /* exported functions ------------------------------------------------------------------*/
 void USARTInit(USART_StructureType);
 void USART_PutChar(uint16_t);
@@ -92,5 +157,22 @@ uint16_t USART_GetChar();
 void USART_EnableInterrupt(USARTCommunicationType);
 void USART_ClearReceiveBuffer();
 void USART_FlushReceiveBuffer();
+uint8_t USART_ReadChar(uint8_t*);
+uint8_t USART_ReceiveCount();
+uint8_t USART_FillReceiveBuffer();
+uint8_t* USART_GetLastLine();
+void USART_DiscardLastLine();
+const USART_LineType* USART_GetLines(uint8_t*);
+uint8_t USART_WriteChar(uint8_t);
+void USART_FlushTransmitBuffer();
+uint16_t USART_BaudRateError(uint32_t, USARTModesType);
+uint8_t USART_SetBaudRate(uint32_t, USARTModesType);
+uint32_t USART_GetBaudRate();
+USARTModesType USART_GetMode();
+#if (USE_FLOW_CONTROL != 0)
+void USART_EnableFlowControl(uint8_t);
+#endif // USE_FLOW_CONTROL
+void USART_GetStats(USART_StatsType*);
+void USART_ClearStats();
 
 #endif // end of __ATMEGA328P_USART_H
@@ -25,15 +25,17 @@ char gThirdUser[20] = "";
 char gLicenseNumber[13] = "";
 
 uint8_t *gCommand;
-uint8_t *gArguement;
+uint8_t *gArguement = (uint8_t*)"";
 
 uint8_t gServiceAcknowledgement = 0;
 uint8_t gDeviceLicensed = 0;
  #if(USE_GSM_MODULE != 0)
 uint8_t gMissedCallFeature = 1;
+uint8_t gMissedCallPattern[MISSED_CALL_PATTERN_LENGTH + 1] = "0F11";	// Quick hang up disabled, any missed call toggles the default switch
+uint8_t gAckByCall = 0;		// OPERATOR_xxx who are acknowledged with the ring back instead of the message
  #endif	//USE_GSM_MODULE
 
-static const Struct_Data_Format COMMANDS[] =
+static const Struct_Data_Format COMMANDS[] PROGMEM =
 {
 	//Set of Action Commands
 	{SWITCH_ON, "SWITCH ON"},
@@ -47,6 +49,9 @@ static const Struct_Data_Format COMMANDS[] =
 #if(USE_GSM_MODULE != 0)
 	{MISSED_CALL_ON, "MISSED CALL FEATURE ON"},
 	{MISSED_CALL_OFF, "MISSED CALL FEATURE OFF"},
+	{SET_MISSED_CALL, "SET MISSED CALL"},
+	{ACK_CALL, "ACK CALL"},
+	{ACK_SMS, "ACK SMS"},
 #endif	//USE_GSM_MODULE
 	{ADD_OPERATOR, "ADD OPERATOR"},
 	{REMOVE_OPERATOR, "REMOVE OPERATOR"},
@@ -55,9 +60,17 @@ static const Struct_Data_Format COMMANDS[] =
 	{SET_LICENSE, "SET LICENSE"},
 	{GET_LICENSE, "GET LICENSE"},
 	{GET_VERSION, "GET VERSION"},
+#if(USE_GSM_MODULE != 0)
+	{GET_BOOT_TIME, "GET BOOT TIME"},
+  #if(USE_MODEM_WATCHDOG != 0)
+	{GET_RECOVERY, "GET RECOVERY"},
+  #endif	//USE_MODEM_WATCHDOG
+	{GET_SIGNAL, "GET SIGNAL"},
+#endif	//USE_GSM_MODULE
 };
 
-const Struct_Data_Format STATUS_CODE[] =
+//Texts of LICENSE_INFO, VERSION_NUMBER and the reports are not fixed, they are built by GSM_AppendStatus()
+const Struct_Data_Format STATUS_CODE[] PROGMEM =
 {
 	{SUCCESSFUL, "SUCCESS"},
 	{DEVICE_ON, "DEVICE IS ON"},
@@ -66,9 +79,7 @@ const Struct_Data_Format STATUS_CODE[] =
 	{SUCCESSFULLY_SWITCHED_OFF, "SUCCESSFULLY SWITCHED OFF"},
 	{SUCCESSFULLY_SWITCHED_ON, "SUCCESSFULLY SWITCHED ON"},
 	{SERVICE_NEEDED, "SERVICE NEEDED"},
-	{LICENSE_INFO, (const char*)gLicenseNumber},
 	{ALREADY_LICENSED, "ALREADY LICENSED"},
-	{VERSION_NUMBER, (const char*)gProductVersion},
 	{FAILED, "FAILED"},
 #if(USE_DETAILED_RESPONSE != 0)
 	{LIST_FULL, "LIST IS FULL"},
@@ -112,10 +123,10 @@ uint8_t licenseCommand()
 	uint8_t retVal = 0xFF;
 	uint8_t cmdLine = 0;
 
-	while((cmdLine < totalNumberOfCommands) && (compareStrings((const char*)gCommand, COMMANDS[cmdLine].data) != 0))
+	while((cmdLine < totalNumberOfCommands) && (compareStrings_P((const char*)gCommand, COMMANDS[cmdLine].data) != 0))
 		cmdLine++;
 
-	if((cmdLine < totalNumberOfCommands) && (COMMANDS[cmdLine].id == SET_LICENSE))
+	if((cmdLine < totalNumberOfCommands) && (pgm_read_byte(&COMMANDS[cmdLine].id) == SET_LICENSE))
 		retVal = 0x00;
 
 	return retVal;
@@ -134,6 +145,18 @@ uint8_t compareStrings(const char* str1, const char* str2)
 	return (strncmp(str1, str2, strlen(str2)));
 }
 
+/*
+ * @name   	compareStrings_P()
+ * @brief	This function is same as compareStrings(), but string 2 is in the flash
+ * @param  	const char* - string 1, in the RAM
+ *			const char* - string 2, in the flash (PROGMEM or PSTR)
+ * @retval	0 - If string 1 starts with string 2
+ */
+uint8_t compareStrings_P(const char* str1, const char* str2)
+{
+	return (strncmp_P(str1, str2, strlen_P(str2)));
+}
+
 /*
  * @name   	processCommand()
  * @brief	This function will compares command with the COMMANDS[] and takes the necessary action
@@ -151,21 +174,21 @@ uint8_t processCommand()
 
 	cmdLine = 0;
 	error = 0;
-	while((cmdLine < totalNumberOfCommands) && (compareStrings((const char*)gCommand, COMMANDS[cmdLine].data) != 0))
+	while((cmdLine < totalNumberOfCommands) && (compareStrings_P((const char*)gCommand, COMMANDS[cmdLine].data) != 0))
 		cmdLine++;
 
 	if(cmdLine < totalNumberOfCommands)
 	{
 		retVal = SUCCESSFUL;
-		switch(COMMANDS[cmdLine].id)
+		switch(pgm_read_byte(&COMMANDS[cmdLine].id))
 		{
 			case SWITCH_ON:
 			case SWITCH_OFF:
 			case GET_SWITCHSTATE:
-					if(gCommandLength > (strlen((const char*)COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
 					{
 #if(USE_GSM_MODULE > 0)
-						GSM_ExtractArguement(strlen((const char*)COMMANDS[cmdLine].data));
+						GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
 #endif	//USE_GSM_MODULE
 						switchLine = 0;
 						while(switchLine<totalNumberOfSwitches)
@@ -181,9 +204,9 @@ uint8_t processCommand()
 						}
 						if(switchLine<totalNumberOfSwitches)
 						{
-							if(COMMANDS[cmdLine].id == SWITCH_ON)
+							if(pgm_read_byte(&COMMANDS[cmdLine].id) == SWITCH_ON)
 								turnON(SWITCHES[switchLine].whichSwitch);
-							else if(COMMANDS[cmdLine].id == SWITCH_OFF)
+							else if(pgm_read_byte(&COMMANDS[cmdLine].id) == SWITCH_OFF)
 								turnOFF(SWITCHES[switchLine].whichSwitch);
 							else
 							{
@@ -206,7 +229,29 @@ uint8_t processCommand()
 				break;
 
 			case TOGGLE_DEFAULT_SWITCH:
-					retVal = toggleDefaultSwitch();
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Switch number or name is mentioned
+					{
+#if(USE_GSM_MODULE > 0)
+						GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
+#endif	//USE_GSM_MODULE
+						switchLine = 1;		// ALL cannot be toggled
+						while(switchLine<totalNumberOfSwitches)
+						{
+							if(((strlen((const char*)SWITCHES[switchLine].name) > 0) \
+								&& (compareStrings((const char*)gArguement, (const char*)SWITCHES[switchLine].name) == 0))	\
+								|| (SWITCHES[switchLine].num == (gArguement[0] - '0')))
+							{
+								break;
+							}
+							switchLine++;
+						}
+						if(switchLine<totalNumberOfSwitches)
+							retVal = toggleSwitch(SWITCHES[switchLine].whichSwitch);
+						else
+							error = 1;
+					}
+					else
+						retVal = toggleDefaultSwitch();
 				break;
 
 			case ACK_OFF:
@@ -228,14 +273,56 @@ uint8_t processCommand()
 					gMissedCallFeature = 1;
 					updateEEPROM(MISSED_CALL_FEATURE, &gMissedCallFeature);
 				break;
+
+			case ACK_CALL:
+			case ACK_SMS:
+					loopCount = GSM_UserOperator();
+					if(loopCount)
+					{
+						if(pgm_read_byte(&COMMANDS[cmdLine].id) == ACK_CALL)
+							gAckByCall |= loopCount;
+						else
+							gAckByCall &= ~loopCount;
+						updateEEPROM(ACK_BY_CALL, &gAckByCall);
+					}
+					else	//Licensing users are not in the operator list
+						retVal = FAILED;
+				break;
+
+			case SET_MISSED_CALL:
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					{
+						if(gFlagLicensingUser || gFlagPrimaryUser)
+						{
+							GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
+							if(GSM_CheckMissedCallPattern(gArguement) == 0x00)
+							{
+								strcpy((char*)gMissedCallPattern, (const char*)gArguement);
+								updateEEPROM(MISSED_CALL_PATTERN, gMissedCallPattern);
+							}
+							else
+								retVal = FAILED;
+						}
+						else
+						{
+#if(USE_DETAILED_RESPONSE != 0)
+							retVal = NOT_AUTHERISED;
+#else	//USE_DETAILED_RESPONSE
+							retVal = FAILED;
+#endif	//USE_DETAILED_RESPONSE
+						}
+					}
+					else
+						error = 1;
+				break;
 #endif //USE_GSM_MODULE
 			case ADD_OPERATOR:
-					if(gCommandLength > (strlen((const char*)COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
 					{
 						if(gFlagLicensingUser || gFlagPrimaryUser)
 						{
 #if(USE_GSM_MODULE > 0)
-							GSM_ExtractArguement(strlen((const char*)COMMANDS[cmdLine].data));
+							GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
 							if(gArguement[0] != '+')
 							{
 								retVal = FAILED;
@@ -295,12 +382,12 @@ uint8_t processCommand()
 				break;
 
 			case REMOVE_OPERATOR:
-					if(gCommandLength > (strlen((const char*)COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
 					{
 						if(gFlagLicensingUser || gFlagPrimaryUser)
 						{
 #if(USE_GSM_MODULE > 0)
-							GSM_ExtractArguement(strlen((const char*)COMMANDS[cmdLine].data));
+							GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
 #endif	//USE_GSM_MODULE
 							if((strlen((const char*)gPrimeUser) > 0) && (compareStrings((const char*)gArguement, (const char*)gPrimeUser) == 0))
 							{
@@ -343,12 +430,12 @@ uint8_t processCommand()
 				break;
 
 			case SET_PRIMARY_USER:
-					if(gCommandLength > (strlen((const char*)COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
 					{
 						if(gFlagLicensingUser)
 						{
 #if(USE_GSM_MODULE > 0)
-							GSM_ExtractArguement(strlen((const char*)COMMANDS[cmdLine].data));
+							GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
 							if(gArguement[0] != '+')
 							{
 								retVal = FAILED;
@@ -420,7 +507,7 @@ uint8_t processCommand()
 				break;
 
 			case SET_LICENSE:
-					if(gCommandLength > (strlen((const char*)COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
+					if(gCommandLength > (strlen_P(COMMANDS[cmdLine].data)))	//Check if gCommand has extra bytes!
 					{
 						if(gFlagLicensingUser)
 						{
@@ -428,10 +515,10 @@ uint8_t processCommand()
 							{
 								gDeviceLicensed = 1;
 #if(USE_GSM_MODULE > 0)
-								GSM_ExtractArguement(strlen((const char*)COMMANDS[cmdLine].data));
+								GSM_ExtractArguement(strlen_P(COMMANDS[cmdLine].data));
 
 #endif	//USE_GSM_MODULE
-								//print("<L: %s>", gArguement);
+								DEBUG_TRACE("<license: %s>\r\n", gArguement);
 								updateEEPROM(DEVICE_LICENSED, &gDeviceLicensed);
 								updateEEPROM(LICENSE_NUMBER, gArguement);
 								strncpy((char *)gLicenseNumber, (const char*)gArguement, strlen((const char*)gArguement));
@@ -485,12 +572,49 @@ uint8_t processCommand()
 					}
 				break;
 
+#if(USE_GSM_MODULE != 0)
+			case GET_BOOT_TIME:
+					if(gFlagLicensingUser)
+						retVal = BOOT_TIME;
+					else
+					{
+#if(USE_DETAILED_RESPONSE != 0)
+						retVal = NOT_AUTHERISED;
+#else	//USE_DETAILED_RESPONSE
+						retVal = FAILED;
+#endif	//USE_DETAILED_RESPONSE
+					}
+				break;
+
+  #if(USE_MODEM_WATCHDOG != 0)
+			case GET_RECOVERY:
+					if(gFlagLicensingUser)
+						retVal = RECOVERY_REPORT;
+					else
+					{
+#if(USE_DETAILED_RESPONSE != 0)
+						retVal = NOT_AUTHERISED;
+#else	//USE_DETAILED_RESPONSE
+						retVal = FAILED;
+#endif	//USE_DETAILED_RESPONSE
+					}
+				break;
+  #endif	//USE_MODEM_WATCHDOG
+
+			case GET_SIGNAL:
+					retVal = SIGNAL_REPORT;	// From the samples, modem is not asked
+				break;
+#endif	//USE_GSM_MODULE
+
 			default:
 				break;
 		}
 
 		if(strlen((const char*)gArguement) > 0)
+		{
 			free(gArguement);
+			gArguement = (uint8_t*)"";		// Commands without arguement are run back to back from the keys of the call
+		}
 	}
 	else
 	{
@@ -36,7 +36,17 @@
  #if(USE_GSM_MODULE != 0)
 #define	MISSED_CALL_OFF			0x22
 #define	MISSED_CALL_ON			0x23
+#define	SET_MISSED_CALL			0x24
+#define	ACK_CALL				0x25
+#define	ACK_SMS					0x26
+#define MISSED_CALL_PATTERN_LENGTH	4	// <quick hang up seconds><action of quick hang up><action of 1 ring><action of 2 rings>
+#define GSM_REPORT_LENGTH		64		// Size of the report texts of GET BOOT TIME, GET RECOVERY and GET SIGNAL, built on request
  #endif	//USE_GSM_MODULE
+//Operators, bit of each in gAckByCall
+#define OPERATOR_PRIMARY		0x01
+#define OPERATOR_SECOND			0x02
+#define OPERATOR_THIRD			0x04
+#define OPERATOR_ALL			0x07
 //Operators related commands
 #define ADD_OPERATOR			0x40
 #define	REMOVE_OPERATOR			0x41
@@ -45,8 +55,17 @@
 //Lincese Command
 #define	SET_LICENSE				0xF0
 #define GET_LICENSE				0xF1
+ #if(USE_GSM_MODULE != 0)
+#define GET_BOOT_TIME			0xF2
+  #if(USE_MODEM_WATCHDOG != 0)
+#define GET_RECOVERY			0xF3
+  #endif	//USE_MODEM_WATCHDOG
+#define GET_SIGNAL				0xF4
+ #endif	//USE_GSM_MODULE
 #define GET_VERSION				0xFF
 
+#define DATA_FORMAT_LENGTH		27		// Longest command name or status message, with the null character
+
 //Status Codes
 #define SUCCESSFUL			        0x00
 #define DEVICE_ON			        0x01
@@ -58,6 +77,13 @@
 #define LICENSE_INFO		        0xA0
 #define ALREADY_LICENSED	        0xA1
 #define VERSION_NUMBER		        0xB0
+ #if(USE_GSM_MODULE != 0)
+#define BOOT_TIME			        0xB1	//Report of the modem bring up
+  #if(USE_MODEM_WATCHDOG != 0)
+#define RECOVERY_REPORT		        0xB2	//Restarts of the hung modem
+  #endif	//USE_MODEM_WATCHDOG
+#define SIGNAL_REPORT		        0xB3	//Signal quality and network registration
+ #endif	//USE_GSM_MODULE
 #define FAILED				        0xFF
  #if(USE_DETAILED_RESPONSE != 0)
 #define LIST_FULL					0x40
@@ -79,8 +105,8 @@
 typedef struct
 {
 	uint8_t id;			//Command Id or status code
-	const char* data;	//Command name or status message
-}Struct_Data_Format;
+	char data[DATA_FORMAT_LENGTH];	//Command name or status message
+}Struct_Data_Format;		// Tables of this are kept in the flash (PROGMEM)
 
 typedef struct
 {
@@ -92,9 +118,9 @@ typedef struct
 /*************************************************************************************************
  * Exported/Imported Variables
  *************************************************************************************************/
-extern const Struct_Data_Format STATUS_CODE[];
+extern const Struct_Data_Format STATUS_CODE[] PROGMEM;
 extern const uint8_t totalNumberOfStatusCodes;
-extern const uint8_t gProductVersion[];
+extern const uint8_t gProductVersion[] PROGMEM;
 extern uint8_t gServiceAcknowledgement; 	// 1 -> Every request will be acknowledged
 extern uint8_t gDeviceLicensed;
 
@@ -102,11 +128,12 @@ extern char gPrimeUser[20];
 extern char gSecondUser[20];
 extern char gThirdUser[20];
 extern char gLicenseNumber[13];
-
 extern uint8_t *gCommand;
 extern uint8_t *gArguement;
  #if(USE_GSM_MODULE != 0)
 extern uint8_t gMissedCallFeature;
+extern uint8_t gMissedCallPattern[MISSED_CALL_PATTERN_LENGTH + 1];
+extern uint8_t gAckByCall;
  #endif	//USE_GSM_MODULE
 
 /*************************************************************************************************
@@ -115,5 +142,6 @@ extern uint8_t gMissedCallFeature;
 uint8_t processCommand();
 uint8_t licenseCommand();
 uint8_t compareStrings(const char*, const char*);
+uint8_t compareStrings_P(const char*, const char*);
 
 #endif	//_COMMANDS_H_
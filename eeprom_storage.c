@@ -28,6 +28,9 @@ const Structure_EEPROM_Layout EEPROM_Layout_Details[] =
 	{MISSED_CALL_FEATURE, 1, 76, 76},
 	{SWITCH_1_STATE, 1, 77, 77},
 	{SWITCH_2_STATE, 1, 78, 78},
+	{MISSED_CALL_PATTERN, 5, 79, 83},
+	{ACK_BY_CALL, 1, 84, 84},
+	{AT_TIMINGS, AT_TIMINGS_SIZE, 85, 85 + AT_TIMINGS_SIZE - 1},
 };
 
 static const uint8_t totalVariables = sizeof(EEPROM_Layout_Details)/sizeof(Structure_EEPROM_Layout);
@@ -49,6 +52,10 @@ void initializeDevice()
 	uint8_t data;
 	uint8_t exitLoop = 0;
 	int j;
+ #if(USE_GSM_MODULE != 0)
+	uint8_t pattern[MISSED_CALL_PATTERN_LENGTH + 1];
+	Struct_AT_Timing timings[AT_TOTAL_CLASSES];
+ #endif	//USE_GSM_MODULE
 
 	eeprom_busy_wait();	//Wait for EEPROM is ready to use
 
@@ -101,6 +108,30 @@ void initializeDevice()
 						gMissedCallFeature = data;
 					break;
 
+ #if(USE_GSM_MODULE != 0)
+				case MISSED_CALL_PATTERN:
+						if(data == '\0')
+							exitLoop = 1;
+						pattern[k] = data;
+						//Default pattern is kept if the EEPROM is not written yet
+						if((exitLoop) && (!GSM_CheckMissedCallPattern(pattern)))
+							strcpy((char*)gMissedCallPattern, (const char*)pattern);
+					break;
+
+				case ACK_BY_CALL:
+						if(data <= OPERATOR_ALL)
+							gAckByCall = data;
+					break;
+
+				case AT_TIMINGS:
+						//Binary, null is not the end. Erased EEPROM reads as AT_TIMEOUT_UNKNOWN
+						if(k < sizeof(timings))
+							((uint8_t*)timings)[k] = data;
+						if(k == (sizeof(timings) - 1))
+							AT_SetTimings(timings);
+					break;
+ #endif	//USE_GSM_MODULE
+
 				case SWITCH_1_STATE:
 						gDefaultSwitchState = data;
 					break;
@@ -161,3 +192,30 @@ void updateEEPROM(uint8_t var, uint8_t *data)
 		}
 	}
 }
+
+/*
+ * @name   	updateEEPROMBlock()
+ * @brief	This function will update the binary EEPROM variable, all the bytes of it
+ * @param  	uint8_t - variable whose data has to be updated in the EEPROM
+ *			uint8_t* - address of the data, size of the variable in the layout
+ * @retval	None
+ * @note	Unlike updateEEPROM(), null is not taken as the end. Bytes which are not changed are not written.
+ */
+void updateEEPROMBlock(uint8_t var, const uint8_t *data)
+{
+	uint8_t i;
+	uint8_t j;
+	int k;
+
+	for(i=0; i<totalVariables; i++)
+	{
+		if(EEPROM_Layout_Details[i].variable == var)
+			break;
+	}
+
+	if(i<totalVariables)
+	{
+		for(k = EEPROM_Layout_Details[i].startAddress, j = 0; k<=EEPROM_Layout_Details[i].endAddress; j++, k++)
+			eeprom_update_byte((uint8_t*)k, data[j]);
+	}
+}
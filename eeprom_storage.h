@@ -31,6 +31,11 @@
 #define	MISSED_CALL_FEATURE		7
 #define SWITCH_1_STATE			8
 #define SWITCH_2_STATE			9
+#define MISSED_CALL_PATTERN		10
+#define ACK_BY_CALL				11
+#define AT_TIMINGS				12		// Latency learnt for each class of AT commands, binary
+
+#define AT_TIMINGS_SIZE			(AT_TOTAL_CLASSES * sizeof(Struct_AT_Timing))	// Follows the classes of at_engine.h
 
 /*************************************************************************************************
  * Structure Definitions
@@ -48,4 +53,5 @@ typedef struct
  *************************************************************************************************/
 void initializeDevice();
 void updateEEPROM(uint8_t, uint8_t*);
+void updateEEPROMBlock(uint8_t, const uint8_t*);
 #endif // _EEPROM_STORAGE
@@ -1,7 +1,9 @@
 #include <avr/io.h>
+#include "atmega328p_clock.h"
 
+//Fuse bytes for the CLOCK_PROFILE selected in wireless_control_config.h
 FUSES = {
-    .low = LFUSE_DEFAULT,
-    .high = HFUSE_DEFAULT,
-    .extended = EFUSE_DEFAULT
+    .low = CLOCK_LFUSE,
+    .high = CLOCK_HFUSE,
+    .extended = CLOCK_EFUSE
 };
@@ -17,29 +17,99 @@
 /*************************************************************************************************
  * #defines
  *************************************************************************************************/
-#define Ctrl_Z  0x1A
+#define GSM_RESPONSE_TIMEOUT		10000	// Maximum wait for the final result code in milliseconds
+#define GSM_SEND_MESSAGE_TIMEOUT	60000	// Sending message depends on the network, +CMGS can take up to 60 seconds
+#define GSM_SYNC_TIMEOUT			300		// AT is answered in few milliseconds once the modem has locked on the baud rate
+#define GSM_RESYNC_ATTEMPTS			10		// AT bursts on each baud rate when the modem is lost after AT+IPR
+#define GSM_SYNC_WAIT				20000	// Bring up gives up if the modem doesn't answer AT for this long
+#define GSM_PURGE_TIMEOUT			25000	// AT+CMGDA="DEL ALL" takes about 15 seconds with a full SIM
+#define GSM_PURGE_BACKOFF			60000	// AT+CMGDA="DEL READ" is not tried again for this long, after it freed nothing
+#define GSM_NETWORK_FIRST_WAIT		250		// First wait between AT+CREG? polls, doubled after every poll
+#define GSM_NETWORK_MAX_WAIT		4000	// Maximum wait between AT+CREG? polls
+#define GSM_NETWORK_REGISTERED(x)	(((x) == 1) || ((x) == 5))	// Home network or roaming
+#define GSM_MAX_RING_WAIT			3		// RINGs from the valid user before the call is answered
+#define GSM_CALL_SESSION_TIMEOUT	30000	// Call is cut if no key is pressed for this long
+#define GSM_RINGBACK_TIME			5000	// Ring back call is cut after ringing for this long
+#define GSM_RINGBACK_GAP			3000	// Gap between the ring back calls of the failure
+#define GSM_CONFIG_LINE_LENGTH		80		// All the settings on one command line, AT + ;<setting> for each setting
+#define GSM_TIMINGS_SAVE_INTERVAL	600000	// Learnt AT command latencies are saved at most once in 10 minutes
+#define GSM_SIGNAL_INTERVAL			60000	// Signal quality and registration are sampled this often while idle
+#define GSM_SIGNAL_RETRY			10000	// Sampled sooner while not registered, acknowledgements wait for it
+#define GSM_SIGNAL_UNKNOWN			99		// <rssi> of +CSQ when it is not known
+#if (USE_MODEM_WATCHDOG != 0)
+#define GSM_PROBE_INTERVAL			30000	// Idle modem is probed with AT this often
+#define GSM_PROBE_RETRY				2000	// Wait before probing again after a failed probe
+#define GSM_PROBE_FAILURES			3		// Failed probes in a row before the modem is restarted
+#define GSM_PWRKEY_PULSE			1200	// PWRKEY is held low for at least 1 second to switch the modem on or off
+#define GSM_PWRKEY_SETTLE			3000	// Modem takes about 2 seconds to power down or to start after the pulse
+#define GSM_POWER_ON_WAIT			5000	// Modem is probed for this long after the settle, before the next pulse
+#define GSM_POWER_MAX_PULSES		3		// Pulse toggles the power, so the 2nd pulse switches on the modem which was switched off
+#define GSM_RECOVERY_TIMEOUT		45000	// Recovery waits for the network only till this, from the restart
+#endif	//USE_MODEM_WATCHDOG
+
+#define GSM_HEADER_LENGTH			64		// +CMT header is kept till here, phone number is at the start of it
+#define GSM_DIRECT_LENGTH			64		// Characters of the direct message kept, commands are shorter
+#define GSM_ACK_LENGTH				100		// Status texts are merged into one acknowledgement till this
+#define GSM_BOOT_REGISTERED			0x00	// Results of the last GSM_BringUp(), for the boot report
+#define GSM_BOOT_NO_NETWORK			0x01
+#define GSM_BOOT_NO_MODEM			0xFF
+#define GSM_STORAGE_MARGIN			3		// Cleanup is urgent when free SIM storage is less than this
+#define GSM_STORAGE_FULL()			((gStorageTotal != 0) && ((gStorageUsed + GSM_STORAGE_MARGIN) >= gStorageTotal))
+
+#if (USE_DEBUG_TRACE != 0)
+#define GSM_TRACE_STATUS(format, code)	GSM_TraceStatus(PSTR(format), code)	// Text of the status code is built only for the trace
+#else
+#define GSM_TRACE_STATUS(format, code)
+#endif // USE_DEBUG_TRACE
 
 /*************************************************************************************************
  * Gloabl Variables and Definition
  *************************************************************************************************/
 static const char* OK_RESPONSE			= "OK";
+static const char MESSAGE_LIST_RESPONSE[] PROGMEM	= "+CMGL: ";
+static const char STORAGE_RESPONSE[] PROGMEM		= "+CPMS: ";
+static const char NETWORK_RESPONSE[] PROGMEM		= "+CREG: ";
+static const char SIGNAL_RESPONSE[] PROGMEM		= "+CSQ: ";
+
+#if (USE_DTMF_CONTROL != 0)
+//Tones played back for the command from the key (AT+VTS), kept in the flash
+static const char TONE_SUCCESS[] PROGMEM		= "\"1\"";
+static const char TONE_STATUS_OFF[] PROGMEM	= "\"1,1\"";
+static const char TONE_FAILED[] PROGMEM		= "\"0,0,0\"";
+#endif	//USE_DTMF_CONTROL
 //const char* ERROR_RESPONSE			= "ERROR";
-static const char* RING_RESPONSE		= "RING";
-static const char*	NO_CARRIER_RESPONSE	= "NO CARRIER";
-static const char* GOT_MESSAGE_RESPONSE	= "+CMTI: ";
 
-static const char* gLicensingUser1 		= "+919686952982";
-static const char* gLicensingUser2 		= "+919886433750";
+static const char gLicensingUser1[] PROGMEM 	= "+919686952982";
+static const char gLicensingUser2[] PROGMEM 	= "+919886433750";
 
 static uint8_t* gResponseDetails;
 static uint8_t gResponseLength;
-static uint8_t gCommandStartPosition;
 static uint8_t gResponseCode;
 
 static eGSM_States gGSMState = GSM_IDLE;
-static const uint8_t gMaxRingWait = 0x03;
+static const uint8_t gMaxRingWait = (GSM_MAX_RING_WAIT > 0) ? GSM_MAX_RING_WAIT : 1;	// Ring count of the valid user starts at 1
 static const uint8_t gDeleteRetries = 0x03;
 
+//Baud rates tried with the modem, highest first. Only the baud rates with in the error for CLOCK_PROFILE are present
+static const Struct_Baud_Rate gBaudRates[] PROGMEM =
+{
+#if (CLOCK_BAUD_MODE(115200) != 0)
+	{115200, "AT+IPR=115200", (USARTModesType)CLOCK_BAUD_MODE(115200)},
+#endif
+#if (CLOCK_BAUD_MODE(57600) != 0)
+	{57600, "AT+IPR=57600", (USARTModesType)CLOCK_BAUD_MODE(57600)},
+#endif
+#if (CLOCK_BAUD_MODE(38400) != 0)
+	{38400, "AT+IPR=38400", (USARTModesType)CLOCK_BAUD_MODE(38400)},
+#endif
+#if (CLOCK_BAUD_MODE(19200) != 0)
+	{19200, "AT+IPR=19200", (USARTModesType)CLOCK_BAUD_MODE(19200)},
+#endif
+	{USART_BASE_BAUD_RATE, "", USART_BASE_MODE},		//End of the list
+};
+static const uint8_t gTotalBaudRates = sizeof(gBaudRates)/sizeof(Struct_Baud_Rate);
+static uint8_t gBaudTried = 0;			// gBaudRates[] index of the last AT+IPR accepted by the modem
+
 static uint8_t gUser[20] = "";
 static uint8_t gValidUser = 0;
 
@@ -48,61 +118,274 @@ uint8_t gFlagPrimaryUser = 0;
 
 uint8_t gCommandLength;
 
+static uint8_t gRingCount = 0;			// 0 till the caller is checked, then number of rings from the valid user
+static uint32_t gCallStart;				// Tick of the first RING of the call
+static uint8_t gMissedCallAction;		// Action of gMissedCallPattern[] for the missed call, run in GSM_MISSED_CALL
+
+//Actions of the missed call patterns, id is the character in gMissedCallPattern[]
+static const Struct_Data_Format MISSED_CALL_ACTIONS[] PROGMEM =
+{
+	{'0',	""},				// Nothing
+	{'1',	"TOGGLE 1"},
+	{'2',	"TOGGLE 2"},
+	{'N',	"SWITCH ON ALL"},
+	{'F',	"SWITCH OFF ALL"},
+};
+static const uint8_t gTotalMissedCallActions = sizeof(MISSED_CALL_ACTIONS)/sizeof(Struct_Data_Format);
+static uint8_t gPendingMessage = 0;		// +CMTI received while the previous request was being processed
+static uint8_t gNetworkStatus = 0;		// <stat> of the last +CREG
+static uint16_t gNetworkLosses = 0;		// Registration lost, counted at the change
+static uint32_t gSignalDeadline = 0;	// Next sample of the signal quality is taken at this tick
+static uint8_t gSignalCurrent = GSM_SIGNAL_UNKNOWN;	// <rssi> of the last +CSQ, 0 to 31
+static uint8_t gSignalMinimum = GSM_SIGNAL_UNKNOWN;
+static uint16_t gSignalAverage = 0;		// Moving average of <rssi> x 8, moves 1/8 towards every sample
+
+#if (USE_DTMF_CONTROL != 0)
+//Command run for the key pressed in the call, id is the key. Rows of the keypad: switch 1, switch 2 and all switches
+static const Struct_Data_Format DTMF_KEYS[] PROGMEM =
+{
+	{'1',	"SWITCH ON 1"},
+	{'2',	"SWITCH OFF 1"},
+	{'3',	"GET SWITCHSTATE 1"},
+	{'4',	"SWITCH ON 2"},
+	{'5',	"SWITCH OFF 2"},
+	{'6',	"GET SWITCHSTATE 2"},
+	{'7',	"SWITCH ON ALL"},
+	{'8',	"SWITCH OFF ALL"},
+	{'0',	"TOGGLE"},
+};
+static const uint8_t gTotalDTMFKeys = sizeof(DTMF_KEYS)/sizeof(Struct_Data_Format);
+
+static uint8_t gCallSession = 0;		// Call is answered and the keys are taken as commands
+static uint32_t gSessionDeadline;		// Call is cut at this tick, moved on every key
+#endif	//USE_DTMF_CONTROL
+
+#if (USE_DIRECT_SMS != 0)
+static uint8_t gDirectHeader[GSM_HEADER_LENGTH + 1];		// +CMT header of the message waiting to be processed
+static uint8_t gDirectMessage[GSM_DIRECT_LENGTH + 1];
+static uint8_t gDirectPending = 0;		// 0x01 - header is received, 0x02 - message is received and waiting to be processed
+#endif	//USE_DIRECT_SMS
+static uint8_t gDeleteCount = 0;		// Number of tries to delete the message
+static uint8_t gProcessedSlots[32];		// Bit for each SIM index, set once the message is processed till it is deleted
+static uint8_t gDeleteSlot;				// SIM index being deleted
+static uint8_t gDeleteIndex[4];			// gDeleteSlot as text
+static uint8_t gCleanupUrgent = 0;		// Processed messages has to be deleted before listing again
+static uint8_t gStorageUsed = 0;		// Messages in SIM storage
+static uint8_t gStorageTotal = 0;		// Capacity of SIM storage, 0 till it is known
+static uint8_t gStorageStale = 1;		// Storage has to be queried with AT+CPMS?
+static uint8_t gStoragePurge = 0;		// Messages left from the previous run has to be deleted, retries left
+static uint8_t gPurgeUsed = 0;			// Used storage before AT+CMGDA="DEL READ", 0 once the result is checked
+static uint32_t gPurgeDeadline = 0;		// AT+CMGDA="DEL READ" is not sent before this
+static uint32_t gTimingsDeadline = 0;	// Learnt latencies are not saved before this
+
+//Modem settings, applied only if they are not applied already. Shadow is cleared when the modem restarts
+static const Struct_Data_Format SETTINGS[] PROGMEM =
+{
+	{GSM_SETTING_ECHO_OFF,		"ATE0"},
+#if (USE_PDU_MODE != 0)
+	{GSM_SETTING_SMS_FORMAT,	"AT+CMGF=0"},
+#else
+	{GSM_SETTING_SMS_FORMAT,	"AT+CMGF=1"},
+#endif	//USE_PDU_MODE
+	{GSM_SETTING_STORAGE,		"AT+CPMS=\"SM\",\"SM\",\"SM\""},
+	{GSM_SETTING_DIRECT_SMS,	"AT+CNMI=2,2,0,0,0"},
+	{GSM_SETTING_CALLER_ID,		"AT+CLIP=1"},
+	{GSM_SETTING_DTMF,			"AT+DDET=1"},
+	{GSM_SETTING_NETWORK_URC,	"AT+CREG=1"},
+};
+static const uint8_t gTotalSettings = sizeof(SETTINGS)/sizeof(Struct_Data_Format);
+
+static uint8_t gSettingsWanted = 0;		// Settings applied at least once, they are applied again after the modem restarts
+static uint8_t gSettingsApplied = 0;	// Shadow of the settings in the modem
+static uint8_t gSettingPending;			// Setting queued by GSM_EnsureSetting()
+static AT_Callback gSettingCallback;
+
+static uint32_t gBootTimes[GSM_TOTAL_PHASES];	// Milliseconds from the start of the bring up till the end of each phase
+static uint8_t gBootResult = GSM_BOOT_NO_MODEM;	// GSM_BOOT_xxx
+
+#if (USE_MODEM_WATCHDOG != 0)
+static uint8_t gProbeFailures = 0;		// Probes failed in a row
+static uint32_t gProbeDeadline = 0;		// Next probe is sent at this tick
+static uint16_t gRecoveries = 0;		// Modem restarted and brought up again
+static uint16_t gRecoveryFailures = 0;	// Modem did not answer even after the PWRKEY pulses
+static uint32_t gRecoveryLast = 0;		// Milliseconds from the restart till the end of the bring up
+static uint32_t gRecoveryTotal = 0;		// Sum of the recovery times, for the mean
+#endif	//USE_MODEM_WATCHDOG
+
+static uint8_t gRingBackCalls = 0;		// Ring back calls left, 1 call for success and 2 for failure
+static uint8_t gRingBackRinging;		// 0x01 while the ring back call is ringing, 0x00 in the gap
+static uint32_t gRingBackDeadline;		// End of the ringing or the gap
+
+static Struct_Acknowledgement gAckQueue[GSM_ACK_QUEUE_LENGTH];
+static uint8_t gAckHead = 0;
+static uint8_t gAckTail = 0;
+static uint8_t gAckSending = 0;			// 0x01 while the acknowledgement at gAckTail is being sent
+static uint8_t gAckCodesSent;			// Status codes of the acknowledgement at gAckTail in the message being sent
+static uint8_t gAckBody[GSM_ACK_LENGTH + 1];	// Message of the acknowledgement being sent
+#if (USE_PDU_MODE != 0)
+static char gAckPDU[PDU_SUBMIT_HEX_LENGTH(GSM_ACK_LENGTH)];	// gAckBody encoded as SMS-SUBMIT
+static uint8_t gAckLength[4];			// Length of gAckPDU as text for AT+CMGS
+static Struct_SMS gSMS;					// Message decoded from PDU
+#endif	//USE_PDU_MODE
+
+/*************************************************************************************************
+ * Private Functions
+ *************************************************************************************************/
 /*************************************************************************************************
  * Function Definition
  *************************************************************************************************/
 /*
- * @name   	GSM_ReceiveWait()
- * @brief	This function will wait for maximum of 10 seconds for ther response form the GSM Module!
+ * @name   	GSM_SendRequest()
+ * @brief	This function will send the AT command to GSM module and wait for the final response
+ * @param  	message  - the AT command that has to be sent to GSM module, in the flash
+ *			response - the expected final response from the GSM module
+ * @retval	0x00	- if GSM responds the expected response for command
+ *			0xFF	- if GSM responds other final response or doesn't respond in GSM_RESPONSE_TIMEOUT
+ * @note	This function blocks, use it only during startup. Commands from the state machine are queued.
+ */
+uint8_t GSM_SendRequest(const char* message, const char* response)
+{
+	return (AT_SendCommand(message, 0, response, GSM_RESPONSE_TIMEOUT) == AT_SUCCESS) ? 0x00 : 0xFF;
+}
+
+/*
+ * @name   	GSM_InvalidateSettings()
+ * @brief	This function marks all the modem settings as not applied
  * @param  	None
- * @retval	0x00	- if GSM responds within 10 seconds
- *			0xFF	- if GSM Module doesn't respond in 10 seconds
- * @note	This function wait for 2 seconds first then for 3 seconds and then 5 seconds.
- *			As _delay_ms is just a decreament counter operation, if there is an receive interrupt it should be captured by USART driver!
+ * @retval	None
+ * @note	Called when the modem is restarted (RDY, +CFUN) or doesn't respond. Settings are applied again from GSM_IDLE
  */
-uint8_t GSM_ReceiveWait()
+static void GSM_InvalidateSettings()
 {
-	uint8_t retVal = 0xFF;
-	
-	//_delay_ms function is anyway decreament operation! So if there is any interrupt it should be capied to receive buffer
-	_delay_ms(2000);	// First wait for 2 seocnds
-	if(!gReceive_Buffer_Full)
+	if(gSettingsApplied)
 	{
-		_delay_ms(3000);	// Then wait for 3 seconds
-		if(!gReceive_Buffer_Full)
-		{
-			_delay_ms(5000);	// At last wait for 5 seconds
-		}
+		DEBUG_TRACE("<settings lost>\r\n");
 	}
-	
-	if(gReceive_Buffer_Full != 0)
-		retVal = 0x00;
-		
-	return retVal;	
+	gSettingsApplied = 0;
 }
- 
- /*
- * @name   	GSM_SendRequest()
- * @brief	This function will send the AT command to GSM module
- * @param  	message  - the AT command that has to be sent to GSM module
- *			response - the expected response from the GSM module
- * @retval	0x00	- if GSM responds the expected response for command
- *			0xFF	- if GSM it respond ERROR
- * @note	500ms delay is necessary after sending the message
+
+/*
+ * @name   	GSM_SettingCommand()
+ * @brief	This function gives the AT command which applies the setting
+ * @param  	setting - one of GSM_SETTING_xxx
+ * @retval	const char* - AT command in the flash
+ *			NULL		- if the setting is not in SETTINGS[]
  */
-uint8_t GSM_SendRequest(const char* message, const char* response)
+static const char* GSM_SettingCommand(uint8_t setting)
 {
-	uint8_t retVal = 0xFF;
-	USART_FlushReceiveBuffer();
+	uint8_t i = 0;
+
+	while((i < gTotalSettings) && (pgm_read_byte(&SETTINGS[i].id) != setting))
+		i++;
 
-	print("%s\r\n", message);
+	if(i == gTotalSettings)
+		return NULL;
 
-	if((!GSM_ReceiveWait()) && (strcmp((const char*)gGSM_Response, response) == 0))
-		retVal = 0x00;
+	return SETTINGS[i].data;
+}
+
+/*
+ * @name   	GSM_ApplySetting()
+ * @brief	This function applies the modem setting and waits till it is complete
+ * @param  	setting - one of GSM_SETTING_xxx
+ * @retval	0x00 	- if the setting is applied now or was already applied
+ *			0xFF	- otherwise
+ * @note	Used during startup. Setting is remembered as wanted, so it is applied again after the modem restarts
+ */
+uint8_t GSM_ApplySetting(uint8_t setting)
+{
+	const char* command = GSM_SettingCommand(setting);
 
-	USART_FlushReceiveBuffer();
+	if(command == NULL)
+		return 0xFF;
 
-	return retVal;
+	gSettingsWanted |= setting;
+
+	if(gSettingsApplied & setting)
+		return 0x00;
+
+	if(GSM_SendRequest(command, OK_RESPONSE))
+		return 0xFF;
+
+	gSettingsApplied |= setting;
+	return 0x00;
+}
+
+/*
+ * @name   	GSM_SettingDone()
+ * @brief	Callback of the AT command queued by GSM_EnsureSetting()
+ * @param  	status - status of the command
+ * @retval	None
+ */
+static void GSM_SettingDone(uint8_t status)
+{
+	if(status == AT_SUCCESS)
+		gSettingsApplied |= gSettingPending;
+	else if(status == AT_TIMED_OUT)
+		GSM_InvalidateSettings();
+
+	gSettingCallback(status);
+}
+
+/*
+ * @name   	GSM_EnsureSetting()
+ * @brief	This function queues the AT command of the setting only if it is not applied already
+ * @param  	setting  - one of GSM_SETTING_xxx
+ *			callback - called with the status, right away if the setting is already applied
+ * @retval	None
+ * @note	Only one setting can be pending at a time, it is the first step of a chain
+ */
+static void GSM_EnsureSetting(uint8_t setting, AT_Callback callback)
+{
+	gSettingsWanted |= setting;
+
+	if(gSettingsApplied & setting)
+	{
+		callback(AT_SUCCESS);
+		return;
+	}
+
+	gSettingPending = setting;
+	gSettingCallback = callback;
+	if(AT_QueueCommand(GSM_SettingCommand(setting), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_SettingDone))
+		callback(AT_FAILED);
+}
+
+/*
+ * @name   	GSM_SettingRestored()
+ * @brief	Callback of GSM_RestoreSettings()
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Setting which is rejected by the modem is not tried again
+ */
+static void GSM_SettingRestored(uint8_t status)
+{
+	if(status == AT_FAILED)
+		gSettingsWanted &= ~gSettingPending;
+
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_RestoreSettings()
+ * @brief	This function applies one of the wanted settings which is lost
+ * @param  	None
+ * @retval	None
+ * @note	gGSMState has to be GSM_WAITING before calling, it is changed to GSM_IDLE once the setting is complete
+ */
+static void GSM_RestoreSettings()
+{
+	uint8_t missing = gSettingsWanted & (~gSettingsApplied);
+
+	missing &= -missing;		// Lowest missing setting
+	if(GSM_SettingCommand(missing) == NULL)
+	{
+		gSettingsWanted &= ~missing;
+		gGSMState = GSM_IDLE;
+		return;
+	}
+
+	GSM_EnsureSetting(missing, GSM_SettingRestored);
 }
 
 /*
@@ -110,19 +393,19 @@ uint8_t GSM_SendRequest(const char* message, const char* response)
  * @brief	This function is to Check whether GSM module is responding for the AT request!
  * @param  	None
  * @retval	0x00	- if GSM responds to the command
- *			0xFF	- if GSM respond ERROR
- * @note
+ *			0xFF	- if GSM respond ERROR or doesn't respond in GSM_SYNC_TIMEOUT
+ * @note	Echo of the command is an intermediate line, only the final result code is compared.
+ *			Timeout is short, so that calling it in a loop sends AT in bursts till the modem autobaud locks
  */
 uint8_t GSM_TestForResponse()
 {
-	uint8_t retVal;
-	
-	retVal = GSM_SendRequest("AT", OK_RESPONSE);
-
-	if(retVal)
-		retVal = GSM_SendRequest("AT", "ATOK");
+	if(AT_SendCommand(PSTR("AT"), 0, OK_RESPONSE, GSM_SYNC_TIMEOUT) != AT_SUCCESS)
+	{
+		GSM_InvalidateSettings();	// Modem may have restarted
+		return 0xFF;
+	}
 
-	return retVal;
+	return 0x00;
 }
 
 /*
@@ -136,405 +419,1947 @@ uint8_t GSM_TestForResponse()
  */
 uint8_t GSM_SetEchoOFF()
 {
-	//return GSM_SendRequest("ATE0", OK_RESPONSE);
-	return GSM_SendRequest("ATE0", "ATE0OK");	//As Echo is not set to OFF yet, ATE0 will also captured in gGSM_Response
+	return GSM_ApplySetting(GSM_SETTING_ECHO_OFF);
 }
 
+#if (USE_FLOW_CONTROL != 0)
 /*
- * @name   	GSM_DeleteAllMessages()
- * @brief	This function is to delete all the messages in the storage media
+ * @name   	GSM_EnableFlowControl()
+ * @brief	This function is to enable RTS/CTS hardware flow control in both modem and USART
  * @param  	None
- * @retval	0x00 	- if all messages deleted successfully
- *			0xFF	- if deleting messages is unsuccessful
- * @note	This function takes total of minimum of 15 seconds to complete the action
+ * @retval	0x00 	- if flow control is enabled
+ *			0xFF	- if modem doesn't accept, flow control is disabled in USART also
+ * @note	RTS is asserted before sending AT+IFC, so that modem can send the response once flow control is enabled in it
  */
-uint8_t GSM_DeleteAllMessages()
+uint8_t GSM_EnableFlowControl()
 {
-	uint8_t retVal = 0xFF;
-	USART_FlushReceiveBuffer();
-
-	print("AT+CMGDA=\"DEL ALL\"\r\n");
+	uint8_t retVal;
 
-	if((!GSM_ReceiveWait()) && (strcmp((const char*)gGSM_Response, OK_RESPONSE) == 0))
-		retVal = 0x00;
-	//During Debug it is needed
-	/*else
-	{
-		print("<del: %s>", gGSM_Response);
-	}*/
+	USART_EnableFlowControl(1);
 
-    USART_FlushReceiveBuffer();
+	retVal = GSM_SendRequest(PSTR("AT+IFC=2,2"), OK_RESPONSE);
+	if(retVal)
+		USART_EnableFlowControl(0);
 
 	return retVal;
 }
+#endif	//USE_FLOW_CONTROL
 
 /*
- * @name   	GSM_SetupForSMS()
- * @brief	This function is to set to text mode and storage medium to SIM storage.
+ * @name   	GSM_SetBaudRate()
+ * @brief	This function switches the USART to the baud rate of gBaudRates[]
+ * @param  	index - index of gBaudRates[]
+ * @retval	None
+ */
+static void GSM_SetBaudRate(uint8_t index)
+{
+	Struct_Baud_Rate baud;
+
+	memcpy_P(&baud, &gBaudRates[index], sizeof(Struct_Baud_Rate));
+	USART_SetBaudRate(baud.baudRate, baud.mode);
+}
+
+/*
+ * @name   	GSM_NegotiateBaudRate()
+ * @brief	This function is to switch the modem link to the highest baud rate that F_CPU can generate
  * @param  	None
- * @retval	0x00 	- if all messages deleted successfully and set to text mode
- *			0xFF	- otherwise
- * @note	This function will also delete the messages. So it will take more than 15 seconds to execute
+ * @retval	0x00 	- if modem responds with the baud rate in use (new or old)
+ *			0xFF	- if the modem is lost after switching and could not be found back
+ * @note	Echo must be OFF before calling this function.
+ *			Baud rates and the modes are selected at compile time for the CLOCK_PROFILE, see gBaudRates[].
+ *			Modem replies OK to AT+IPR with old baud rate and then switches, so USART is switched after OK.
+ *			If modem doesn't respond with new baud rate, USART is switched back to old baud rate and the next one is tried.
+ *			AT+IPR is not saved in the modem (no AT&W), so modem comes back with default baud rate after power cycle.
  */
-uint8_t GSM_SetupForSMS()
+uint8_t GSM_NegotiateBaudRate()
 {
-	uint8_t retVal = 0xFF;
-	//Set the SMS to text mode
-	if(GSM_SendRequest("AT+CMGF=1", OK_RESPONSE) == 0x00)
+	uint8_t i;
+	uint32_t oldBaudRate = USART_GetBaudRate();
+	USARTModesType oldMode = USART_GetMode();
+
+	for(i = 0; (i < gTotalBaudRates) && (pgm_read_dword(&gBaudRates[i].baudRate) > oldBaudRate); i++)
 	{
-		USART_FlushReceiveBuffer();
+		if(GSM_SendRequest(gBaudRates[i].command, OK_RESPONSE) != 0x00)
+			continue;
 
-		//Set the storage media as SIM CARD
-		_delay_ms(500);
-		print("AT+CPMS=\"SM\",\"SM\",\"SM\"\r\n");
-		
-		GSM_ReceiveWait();	// Wait for some time to recieve some data!
-		USART_FlushReceiveBuffer();		//Clear Buffer
+		gBaudTried = i;
+		GSM_SetBaudRate(i);
+		_delay_ms(100);		//Give time for modem to switch
 
-		//Delete all message
-		_delay_ms(500);
-		retVal = GSM_DeleteAllMessages();
+		if(!GSM_TestForResponse())
+			return 0x00;
+
+		//Modem is not in sync with new baud rate. Switch back and check whether modem is still with old baud rate
+		USART_SetBaudRate(oldBaudRate, oldMode);
+		_delay_ms(100);
+		if(GSM_TestForResponse())
+			return 0xFF;
 	}
-	return retVal;
+
+	return 0x00;
 }
 
 /*
- * @name   	GSM_SetPrimayUser()
- * @brief	This function will store one of the licensing user as primary user
- * @param  	number  - phone number of the licensing user
- * @retval	None
- * @note
+ * @name   	GSM_ResyncBaudRate()
+ * @brief	This function finds the modem back, when it is lost after the baud rate is negotiated
+ * @param  	None
+ * @retval	0x00 	- if the modem answers, USART is left with the baud rate it answered
+ *			0xFF	- if it doesn't answer in GSM_RESYNC_ATTEMPTS on each baud rate, USART is left with the base baud rate
+ * @note	Modem may have switched to the baud rate of the last AT+IPR or may still be at the base baud rate,
+ *			so AT is sent alternately with both.
  */
-void GSM_SetPrimayUser(const char* number)
+static uint8_t GSM_ResyncBaudRate()
 {
-	strcpy(gPrimeUser, number);
-	updateEEPROM(PRIMARY_OPERATOR, (uint8_t*)gPrimeUser);
+	uint8_t attempt;
+
+	for(attempt = 0; attempt < GSM_RESYNC_ATTEMPTS; attempt++)
+	{
+		USART_SetBaudRate(USART_BASE_BAUD_RATE, USART_BASE_MODE);
+		_delay_ms(100);
+		if(!GSM_TestForResponse())
+			return 0x00;
+
+		GSM_SetBaudRate(gBaudTried);
+		_delay_ms(100);
+		if(!GSM_TestForResponse())
+			return 0x00;
+	}
+
+	USART_SetBaudRate(USART_BASE_BAUD_RATE, USART_BASE_MODE);
+	DEBUG_TRACE("<modem lost after AT+IPR>\r\n");
+	return 0xFF;
 }
 
 /*
- * @name   	GSM_CheckValidUser()
- * @brief	This function will whether the message or call received from the valid user
- * @param  	doubelQuoteOccurance - is the occurance of double quote in the response when either call or message is received
- *			doubelQuoteOccurance == 1 for the call
- *			doubelQuoteOccurance == 3 for message
- * @retval	0x00 	- if user is autherised user
+ * @name   	GSM_ApplySettings()
+ * @brief	This function applies all the given modem settings with one command line
+ * @param  	settings - GSM_SETTING_xxx ORed
+ * @retval	0x00 	- if all the settings are applied now or were already applied
  *			0xFF	- otherwise
- * @note	This function will look for the occurance of double quote in '"' in the reponse. and get the phone number from there!
- *			'+' is not present with number then, a '+' will be added in the valid user buffer
+ * @note	Settings are joined like ATE0;+CMGF=1;+CLIP=1, so that only one final result code is waited for.
+ *			Only the settings on the line are taken as applied by its OK. Settings which did not fit on the line,
+ *			or all of them if the modem rejects the line, are applied one by one, so that only the rejected ones are lost.
  */
-uint8_t GSM_CheckValidUser(uint8_t doubelQuoteOccurance)
+uint8_t GSM_ApplySettings(uint8_t settings)
 {
-    uint8_t  retVal = 0xFF;
-	uint8_t i = 0, j = 0;
-	uint8_t count = 0;
-	
-	gValidUser = 0;
+	char line[GSM_CONFIG_LINE_LENGTH];
+	uint8_t length = 2;
+	uint8_t included = 0;		// Settings on the line
+	uint8_t retVal = 0x00;
+	uint8_t id;
+	uint8_t i;
 
-	_delay_ms(100);		//Delay is necessary!
-	gResponseDetails = gGSM_Response;
+	gSettingsWanted |= settings;
+	settings &= ~gSettingsApplied;
+	if(settings == 0)
+		return 0x00;
 
-	gResponseLength = strlen((const char*)gGSM_Response);
-	count = 0;
-	//find the double quote occurance
-	for(i=1; i<gResponseLength; i++)
+	strcpy_P(line, PSTR("AT"));
+	for(i = 0; i < gTotalSettings; i++)
 	{
-		if(gResponseDetails[i] == '"')
-			count++;
-
-		if(count == doubelQuoteOccurance)
-			break;
+		id = pgm_read_byte(&SETTINGS[i].id);
+		if((settings & id) && ((length + strlen_P(SETTINGS[i].data)) < GSM_CONFIG_LINE_LENGTH))
+		{
+			if(length > 2)
+				line[length++] = ';';
+			strcpy_P(&line[length], &SETTINGS[i].data[2]);	// Skip "AT"
+			length += strlen(&line[length]);
+			included |= id;
+		}
 	}
 
-	//if '+' is not preceeded with the phone number then add +!
-	if(gResponseDetails[i+1] != '+')
+	if(AT_SendCommand(PSTR("%s"), line, OK_RESPONSE, GSM_RESPONSE_TIMEOUT) == AT_SUCCESS)
 	{
-		gResponseDetails[i] = '+';
+		gSettingsApplied |= included;
+		settings &= ~included;
 	}
 	else
-		i++;
-
-	//Now copy the number with '+' sign
-	for( j = 0; gResponseDetails[i] != '"'; i++, j++)
-		gUser[j] = gResponseDetails[i];
-
-	gUser[j] = '\0';
-	//print("++V: %s++", gUser);
-
-	_delay_ms(200);
-	//Compare the number with the valid user list!
-	//if(strcmp((const char*)gUser, gPrimeUser) == 0)
-	gFlagLicensingUser = 0;
-	gFlagPrimaryUser = 0;
-	if((strlen((const char*)gPrimeUser) > 0) && (compareStrings((const char*)gPrimeUser, (const char*)gUser) == 0))
-	{
-		gFlagPrimaryUser = 1;
-		gValidUser = 1;
-		retVal = 0x00;
-	}
-	else if((strlen((const char*)gSecondUser) > 0) && (compareStrings((const char*)gSecondUser, (const char*)gUser) == 0))
-	{
-		gValidUser = 1;
-		retVal = 0x00;
-	}
-	else if((strlen((const char*)gThirdUser) > 0) && (compareStrings((const char*)gThirdUser, (const char*)gUser) == 0))
 	{
-		gValidUser = 1;
-		retVal = 0x00;
+		DEBUG_TRACE("<config: %s>\r\n", line);
 	}
 
-	//Check if the user is a gLicensingUser1
-	if((compareStrings((const char*)gUser, (const char*)gLicensingUser1) == 0) || (compareStrings((const char*)gUser, (const char*)gLicensingUser2) == 0))
+	for(i = 0; i < gTotalSettings; i++)
 	{
-		gFlagLicensingUser = 1;
-		gValidUser = 1;
-		retVal = 0x00;
+		id = pgm_read_byte(&SETTINGS[i].id);
+		if((settings & id) && GSM_ApplySetting(id))
+			retVal = 0xFF;
 	}
 
-    return retVal;
+	return retVal;
 }
 
 /*
- * @name   	GSM_PlayAudio()
- * @brief	This function will play audio option for the user
+ * @name   	GSM_StartupSettings()
+ * @brief	This function gives the modem settings applied by GSM_SetupForSMS()
  * @param  	None
- * @retval	<Not Defined yet>
- * @note	This function will play the audio option for the user
+ * @retval	GSM_SETTING_xxx ORed
  */
-void GSM_PlayAudio()
+static uint8_t GSM_StartupSettings()
 {
-	//Yet to implement!
+	uint8_t settings = GSM_SETTING_ECHO_OFF | GSM_SETTING_SMS_FORMAT | GSM_SETTING_STORAGE | GSM_SETTING_CALLER_ID
+						| GSM_SETTING_NETWORK_URC;		// Registration changes are reported as +CREG
+
+#if (USE_DIRECT_SMS != 0)
+	//Deliver the new messages directly as +CMT, without storing in SIM
+	settings |= GSM_SETTING_DIRECT_SMS;
+#endif	//USE_DIRECT_SMS
+#if (USE_DTMF_CONTROL != 0)
+	//Report the keys pressed in the call as +DTMF
+	settings |= GSM_SETTING_DTMF;
+#endif	//USE_DTMF_CONTROL
+
+	return settings;
 }
 
 /*
- * @name   	GSM_HandleCall()
- * @brief	This function check for the number of rings from the autherised user
+ * @name   	GSM_SetupForSMS()
+ * @brief	This function is to set to text mode and storage medium to SIM storage.
  * @param  	None
- * @retval	None
- * @note	This function will increment the ring count given by the user
- *			If gMaxRingWait count is reached it will accept the call and play the audio option.
- *			If gMaxRingWait count is not reached then gGSMState will be changed to GSM_MISSED_CALL
+ * @retval	0x00 	- if the settings are applied
+ *			0xFF	- otherwise
+ * @note	Messages left in the storage are deleted later by the state machine, as deleting them takes more than 15 seconds
  */
-void GSM_HandleCall()
+uint8_t GSM_SetupForSMS()
 {
-	uint8_t ringCount = 0;
-
-	ringCount++;
+	gStoragePurge = gDeleteRetries;
 
-	while(ringCount < gMaxRingWait)
-	{
-		while(!gReceive_Buffer_Full)
-			;
+	return GSM_ApplySettings(GSM_StartupSettings());
+}
 
-		if(strcmp((const char*)gGSM_Response, (const char*)RING_RESPONSE) == 0)
-			ringCount++;
+/*
+ * @name   	GSM_ParseNetworkStatus()
+ * @brief	This function reads <stat> from the +CREG line
+ * @param  	line - +CREG: <stat> (unsolicited) or +CREG: <n>,<stat> (response of AT+CREG?)
+ * @retval	<stat>
+ */
+static uint8_t GSM_ParseNetworkStatus(const char* line)
+{
+	const char* stat = strchr(line, ',');
 
-		else if(strcmp((const char*)gGSM_Response, (const char*)NO_CARRIER_RESPONSE) == 0)
-			break;
+	return atoi(stat ? (stat + 1) : &line[7]);	// Skip "+CREG: "
+}
 
-		USART_FlushReceiveBuffer();
-	}
+/*
+ * @name   	GSM_SetNetworkStatus()
+ * @brief	This function keeps the registration status and counts the losses of the registration
+ * @param  	stat - <stat> of +CREG
+ * @retval	None
+ */
+static void GSM_SetNetworkStatus(uint8_t stat)
+{
+	if(GSM_NETWORK_REGISTERED(gNetworkStatus) && (!GSM_NETWORK_REGISTERED(stat)))
+		gNetworkLosses++;
 
-	if(ringCount >= gMaxRingWait)
-	{
-		GSM_PlayAudio();
-		GSM_SendRequest("ATH0", OK_RESPONSE);
-		gGSMState = GSM_IDLE;
-	}
-	else	//Missed call! Toggle the default switch
-	{
-		gGSMState = GSM_MISSED_CALL;
-	}
+	gNetworkStatus = stat;
 }
 
 /*
- * @name   	GSM_ExtractArguement()
- * @brief	This function extract the arguement 
- * @param  	uint8_t - lenght of the command which was sent!
+ * @name   	GSM_NetworkQueried()
+ * @brief	Callback of AT+CREG?
+ * @param  	status - status of the command
  * @retval	None
- * @note	This function will extract the arguement from the message response captured in gGSM_Response
- *			Ex of command sent is: SWITCH ON ALL,
- *			SWITCH ON - is a command
- *			ALL		  - is an arguement
  */
-void GSM_ExtractArguement(uint8_t length)
+static void GSM_NetworkQueried(uint8_t status)
 {
+	uint8_t lineCount;
+	const USART_LineType* lines = USART_GetLines(&lineCount);
 	uint8_t i;
-	uint8_t size;
-	uint8_t arguementStartPosition;
-	
-	size = (gCommandLength - (length + 1));
-	arguementStartPosition = gCommandStartPosition + length + 1;
-	
-	//gResponseDetails += (length + 1);
-	gArguement = (uint8_t *)malloc((sizeof(uint8_t) * size) + 1);
-	//strncpy((char *)gArguement, (const char*)gResponseDetails, (gCommandLength - (length + 1)));
-	for(i = 0; i< size; i++)
+
+	if(status != AT_SUCCESS)
+		return;
+
+	for(i = 0; i < lineCount; i++)
 	{
-		gArguement[i] = gGSM_Response[arguementStartPosition + i];
+		if(compareStrings_P((const char*)&gGSM_Response[lines[i].offset], NETWORK_RESPONSE) == 0)
+			GSM_SetNetworkStatus(GSM_ParseNetworkStatus((const char*)&gGSM_Response[lines[i].offset]));
 	}
-	gArguement[i] = '\0';
 }
 
 /*
- * @name   	GSM_ProcessMessage()
- * @brief	This function will process the message and do the action accordingly!
- * @param  	None
- * @retval	0x00 - if message received from autherised user and appropriate action has been taken place
- *			0xFF - otherwise
- * @note	This function will check whether user is autherised user
- *			Then from the end look for first double quote '"'
- *			Extract command
- *			This function will delete the message. Hence it will take at least 15 seconds to respond!
- *			User has to provide minimum of 15 seconds after a message has been sent to give next command.
- *			if any new command sent or called in proper response is not guarenteed!
+ * @name   	GSM_WaitForNetwork()
+ * @brief	This function polls the network registration with AT+CREG? till the modem is registered
+ * @param  	timeout - maximum wait in milliseconds, it is polled at least once
+ * @retval	0x00 	- if the modem is registered to home network or roaming
+ *			0xFF	- if it is not registered in timeout
+ * @note	Wait between the polls is doubled every time, till GSM_NETWORK_MAX_WAIT
  */
-uint8_t GSM_ProcessMessage()
+uint8_t GSM_WaitForNetwork(uint32_t timeout)
 {
-	uint8_t retVal = FAILED;
-	uint8_t i = 0;
-
-	USART_FlushReceiveBuffer();
+	uint32_t start = TIMER_GetTicks();
+	uint32_t wait = GSM_NETWORK_FIRST_WAIT;
+	uint32_t polled;
 
-	//Set for Text format
-	if(GSM_SendRequest("AT+CMGF=1", OK_RESPONSE) == 0x00)
+	while(1)
 	{
-		USART_FlushReceiveBuffer();
-		//Read the message
-		print("AT+CMGR=1\r\n");	//Read Message in location 1
-
-		if(!GSM_ReceiveWait())
+		if(AT_QueueCommand(PSTR("AT+CREG?"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_NetworkQueried) == 0x00)
 		{
-			if(!GSM_CheckValidUser(3))	// 3rd occurance of double quote
-			{
-				gResponseDetails = gGSM_Response;
-				gResponseLength = strlen((const char*) gGSM_Response);
-				//check for first " from the end!
-				for(i = gResponseLength-1; i>=0; i--)
-				{
-					if(gResponseDetails[i] == '"')
-					{
-						gCommandStartPosition = i;
-						break;
-					}
-				}
-
-				//Extract the gCommand
-				gCommandStartPosition += 1;
-				gCommandLength = gResponseLength - 2 - gCommandStartPosition;
-
-				//gResponseDetails = gGSM_Response;
-				//gResponseDetails += gCommandStartPosition;
-				gCommand = (uint8_t *)(malloc((sizeof(uint8_t) * gCommandLength) + 1));
-				//strncpy((char *)gCommand, (const char*)gResponseDetails, gCommandLength);
-				for(i = 0; i<gCommandLength ; i++)
-					gCommand[i] = gGSM_Response[gCommandStartPosition + i];
-				gCommand[i] = '\0';
-				
-				//Needed for Debug!
-				//print("<msg: %s>", gGSM_Response);
-				//print("<Resp: %s>", gResponseDetails);
-				//print("<cmd: %s>", gCommand);
-
-				if((gDeviceLicensed) || ((!gDeviceLicensed) && (!licenseCommand())))
-				{
-					retVal = processCommand();
-				}
-#if(USE_DETAILED_RESPONSE != 0)
-				else
-					retVal = NOT_LICENSED;
-#endif	//USE_DETAILED_RESPONSE
-				if(strlen((const char*)gCommand));
-					free(gCommand);
-			}
-#if(USE_DETAILED_RESPONSE != 0)
-			else
-				retVal = INVALID_USER;
-#endif	//USE_DETAILED_RESPONSE
+			while(!AT_IsIdle())
+				AT_Poll();
+		}
 
-			/*USART_FlushReceiveBuffer();
-			
-			//If in some cases deleting messages fails, retry for maximum allowed number of times
-			for(i = 0; i < gDeleteRetries; i++)
-			{
-				if(!GSM_DeleteAllMessages())
-					break;
-			}
-			if(i >= 3)
-				retVal = SERVICE_NEEDED;
+		if(GSM_NETWORK_REGISTERED(gNetworkStatus))
+			return 0x00;
 
-			USART_FlushReceiveBuffer();*/
-		}
-#if(USE_DETAILED_RESPONSE != 0)
-		else
-			retVal = TIMEOUT;
-#endif	//USE_DETAILED_RESPONSE
-	}
-	
-	//If message is recieved, success or failure in processing command, messages should be deleted!
-	USART_FlushReceiveBuffer();		
-	//If in some cases deleting messages fails, retry for maximum allowed number of times
-	for(i = 0; i < gDeleteRetries; i++)
-	{
-		if(!GSM_DeleteAllMessages())
-			break;
-	}
-	if(i >= 3)
-		retVal = SERVICE_NEEDED;
+		if((TIMER_GetTicks() - start) >= timeout)
+			return 0xFF;
 
-	USART_FlushReceiveBuffer();
+		polled = TIMER_GetTicks();
+		while((TIMER_GetTicks() - polled) < wait)
+			AT_Poll();
 
-	return retVal;
+		if(wait < GSM_NETWORK_MAX_WAIT)
+			wait <<= 1;
+	}
 }
 
 /*
- * @name   	GSM_AcknowledgeService()
- * @brief	This function will reply back the acknowledgement for the service
+ * @name   	GSM_AppendText()
+ * @brief	This function appends the text to the report, as much as fits
+ * @param  	report - text to append to
+ *			size   - size of report, with the null character
+ *			text   - text to append, in the flash
+ * @retval	None
+ */
+static void GSM_AppendText(char* report, uint8_t size, const char* text)
+{
+	uint8_t length = strlen(report);
+
+	while((pgm_read_byte(text) != '\0') && ((length + 1) < size))
+		report[length++] = pgm_read_byte(text++);
+	report[length] = '\0';
+}
+
+/*
+ * @name   	GSM_AppendNumber()
+ * @brief	This function appends the label and the number as text to the report, as much as fits
+ * @param  	report - text to append to
+ *			size   - size of report, with the null character
+ *			label  - text before the number, in the flash
+ *			number - number to append
+ * @retval	None
+ */
+static void GSM_AppendNumber(char* report, uint8_t size, const char* label, uint32_t number)
+{
+	char digits[11];
+	uint8_t i = sizeof(digits) - 1;
+
+	digits[i] = '\0';
+	do
+	{
+		digits[--i] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	GSM_AppendText(report, size, label);
+	strncat(report, &digits[i], size - 1 - strlen(report));
+}
+
+/*
+ * @name   	GSM_BootReport()
+ * @brief	This function appends the report of the last bring up, time at the end of each phase
+ * @param  	report - text to append to
+ *			size   - size of report, with the null character
+ * @retval	None
+ */
+static void GSM_BootReport(char* report, uint8_t size)
+{
+	GSM_AppendNumber(report, size, PSTR("SYNC "), gBootTimes[GSM_PHASE_SYNC]);
+	if(gBootResult == GSM_BOOT_NO_MODEM)
+	{
+		GSM_AppendText(report, size, PSTR(" MS NO MODEM"));
+		return;
+	}
+
+	GSM_AppendNumber(report, size, PSTR(" LINK "), gBootTimes[GSM_PHASE_LINK]);
+	GSM_AppendNumber(report, size, PSTR(" CONFIG "), gBootTimes[GSM_PHASE_CONFIG]);
+	GSM_AppendNumber(report, size, PSTR(" NETWORK "), gBootTimes[GSM_PHASE_NETWORK]);
+	GSM_AppendText(report, size, (gBootResult == GSM_BOOT_REGISTERED) ? PSTR(" MS") : PSTR(" MS NO NETWORK"));
+}
+
+#if (USE_MODEM_WATCHDOG != 0)
+/*
+ * @name   	GSM_RecoveryReport()
+ * @brief	This function appends the report of the restarts of the hung modem and their time
+ * @param  	report - text to append to
+ *			size   - size of report, with the null character
+ * @retval	None
+ */
+static void GSM_RecoveryReport(char* report, uint8_t size)
+{
+	GSM_AppendNumber(report, size, PSTR("RECOVERED "), gRecoveries);
+	GSM_AppendNumber(report, size, PSTR(" FAILED "), gRecoveryFailures);
+	if(gRecoveries != 0)
+	{
+		GSM_AppendNumber(report, size, PSTR(" LAST "), gRecoveryLast);
+		GSM_AppendNumber(report, size, PSTR(" MEAN "), gRecoveryTotal / gRecoveries);
+		GSM_AppendText(report, size, PSTR(" MS"));
+	}
+}
+#endif	//USE_MODEM_WATCHDOG
+
+/*
+ * @name   	GSM_SignalReport()
+ * @brief	This function appends the report of the signal quality and the registration sampled while idle
+ * @param  	report - text to append to
+ *			size   - size of report, with the null character
+ * @retval	None
+ * @note	Unknown <rssi> (99) is reported but not taken in the minimum and the average
+ */
+static void GSM_SignalReport(char* report, uint8_t size)
+{
+	if((gSignalCurrent == GSM_SIGNAL_UNKNOWN) && (gSignalMinimum == GSM_SIGNAL_UNKNOWN))
+	{
+		GSM_AppendText(report, size, PSTR("NOT SAMPLED"));
+		return;
+	}
+
+	GSM_AppendNumber(report, size, PSTR("CSQ "), gSignalCurrent);
+	if(gSignalMinimum != GSM_SIGNAL_UNKNOWN)
+	{
+		GSM_AppendNumber(report, size, PSTR(" MIN "), gSignalMinimum);
+		GSM_AppendNumber(report, size, PSTR(" AVG "), (gSignalAverage + 4) >> 3);
+	}
+	if(gNetworkStatus == 1)
+		GSM_AppendText(report, size, PSTR(" HOME"));
+	else if(gNetworkStatus == 5)
+		GSM_AppendText(report, size, PSTR(" ROAMING"));
+	else
+		GSM_AppendText(report, size, PSTR(" NO NETWORK"));
+	GSM_AppendNumber(report, size, PSTR(" LOST "), gNetworkLosses);
+}
+
+/*
+ * @name   	GSM_AppendStatus()
+ * @brief	This function appends the text of the status code, as much as fits
+ * @param  	text - text to append to
+ *			size - size of text, with the null character
+ *			code - status code from STATUS_CODE[], LICENSE_INFO, VERSION_NUMBER or one of the reports
+ * @retval	None
+ * @note	Texts which are not fixed are built on request, nothing is appended for the code which is not known
+ */
+static void GSM_AppendStatus(char* text, uint8_t size, uint8_t code)
+{
+	uint8_t i = 0;
+
+	switch(code)
+	{
+		case LICENSE_INFO:
+			strncat(text, gLicenseNumber, size - 1 - strlen(text));
+			break;
+
+		case VERSION_NUMBER:
+			GSM_AppendText(text, size, (const char*)gProductVersion);
+			break;
+
+		case BOOT_TIME:
+			GSM_BootReport(text, size);
+			break;
+
+#if (USE_MODEM_WATCHDOG != 0)
+		case RECOVERY_REPORT:
+			GSM_RecoveryReport(text, size);
+			break;
+#endif	//USE_MODEM_WATCHDOG
+
+		case SIGNAL_REPORT:
+			GSM_SignalReport(text, size);
+			break;
+
+		default:
+			while((i < totalNumberOfStatusCodes) && (pgm_read_byte(&STATUS_CODE[i].id) != code))
+				i++;
+			if(i < totalNumberOfStatusCodes)
+				GSM_AppendText(text, size, STATUS_CODE[i].data);
+			break;
+	}
+}
+
+#if (USE_DEBUG_TRACE != 0)
+/*
+ * @name   	GSM_TraceStatus()
+ * @brief	This function prints the text of the status code on the debug port
+ * @param  	format - format with one %s for the text, in the flash
+ *			code   - status code, see GSM_AppendStatus()
+ * @retval	None
+ */
+static void GSM_TraceStatus(const char* format, uint8_t code)
+{
+	char text[GSM_REPORT_LENGTH] = "";
+
+	GSM_AppendStatus(text, sizeof(text), code);
+	debugPrint_P(format, text);
+}
+#endif	//USE_DEBUG_TRACE
+
+/*
+ * @name   	GSM_BringUp()
+ * @brief	This function brings up the modem, till it is ready to take the requests
+ * @param  	networkWait - maximum wait for the network registration in milliseconds, ex: GSM_NETWORK_TIMEOUT
+ * @retval	0x00	- if the modem answered, even if it is not registered to the network
+ *			0xFF	- if the modem did not answer AT in GSM_SYNC_WAIT
+ * @note	Phases are sync with the modem (AT bursts for autobaud), link (flow control and baud rate),
+ *			configuration (one command line) and network registration. Time at the end of each phase, from
+ *			the start of the bring up, is kept in gBootTimes[] and reported with GET BOOT TIME.
+ *			If the modem doesn't answer, settings are left as wanted and applied from GSM_IDLE once it answers.
+ *			Called again by GSM_Recover() after the hung modem is restarted.
+ */
+uint8_t GSM_BringUp(uint32_t networkWait)
+{
+	uint32_t start = TIMER_GetTicks();
+	uint32_t deadline = start + GSM_SYNC_WAIT;
+	uint8_t synced;
+
+ #if(USE_MODEM_WATCHDOG != 0)
+	GPIO_Config(GSM_PWRKEY_PORT, GSM_PWRKEY_PIN, OUTPUT);
+	GPIO_Write(GSM_PWRKEY_PORT, GSM_PWRKEY_PIN, GSM_PWRKEY_INACTIVE);
+ #endif // USE_MODEM_WATCHDOG
+
+	do
+		synced = GSM_TestForResponse();		//AT bursts till the modem locks on the baud rate
+	while(synced && (!TIMER_Expired(deadline)));
+	gBootTimes[GSM_PHASE_SYNC] = TIMER_GetTicks() - start;
+
+	if(synced)
+	{
+		gSettingsWanted |= GSM_StartupSettings();
+		gBootResult = GSM_BOOT_NO_MODEM;
+		GSM_TRACE_STATUS("<boot: %s>\r\n", BOOT_TIME);
+		return 0xFF;
+	}
+
+ #if(USE_FLOW_CONTROL != 0)
+	GSM_EnableFlowControl();		//Enable before moving to higher baud rate, so that no data is lost
+ #endif // USE_FLOW_CONTROL
+
+	//Move to higher baud rate if the modem and F_CPU supports. If modem is lost, find it back on the base or the new baud rate
+	if(GSM_NegotiateBaudRate())
+		GSM_ResyncBaudRate();
+	gBootTimes[GSM_PHASE_LINK] = TIMER_GetTicks() - start;
+
+	GSM_SetupForSMS();
+	gBootTimes[GSM_PHASE_CONFIG] = TIMER_GetTicks() - start;
+
+	GSM_WaitForNetwork(networkWait);
+	gBootTimes[GSM_PHASE_NETWORK] = TIMER_GetTicks() - start;
+
+	gBootResult = GSM_NETWORK_REGISTERED(gNetworkStatus) ? GSM_BOOT_REGISTERED : GSM_BOOT_NO_NETWORK;
+	GSM_TRACE_STATUS("<boot: %s>\r\n", BOOT_TIME);
+
+	return 0x00;
+}
+
+#if (USE_MODEM_WATCHDOG != 0)
+/*
+ * @name   	GSM_Wait()
+ * @brief	This function waits for the time, unsolicited result codes are handled meanwhile
+ * @param  	wait - milliseconds
+ * @retval	None
+ */
+static void GSM_Wait(uint32_t wait)
+{
+	uint32_t deadline = TIMER_GetTicks() + wait;
+
+	while(!TIMER_Expired(deadline))
+		AT_Poll();
+}
+
+/*
+ * @name   	GSM_PowerKeyPulse()
+ * @brief	This function pulls the PWRKEY of the modem low for GSM_PWRKEY_PULSE and waits till it settles
+ * @param  	None
+ * @retval	None
+ * @note	Pulse switches off the modem which is on and switches on the modem which is off
+ */
+static void GSM_PowerKeyPulse()
+{
+	GPIO_Write(GSM_PWRKEY_PORT, GSM_PWRKEY_PIN, GSM_PWRKEY_ACTIVE);
+	GSM_Wait(GSM_PWRKEY_PULSE);
+	GPIO_Write(GSM_PWRKEY_PORT, GSM_PWRKEY_PIN, GSM_PWRKEY_INACTIVE);
+	GSM_Wait(GSM_PWRKEY_SETTLE);
+}
+
+/*
+ * @name   	GSM_ProbeDone()
+ * @brief	Callback of the AT probe sent while idle
+ * @param  	status - status of AT
+ * @retval	None
+ * @note	After a failed probe, next one is sent sooner. GSM_PROBE_FAILURES in a row restarts the modem.
+ */
+static void GSM_ProbeDone(uint8_t status)
+{
+	if(status == AT_SUCCESS)
+		gProbeFailures = 0;
+	else
+		gProbeFailures++;
+
+	gProbeDeadline = TIMER_GetTicks() + (gProbeFailures ? GSM_PROBE_RETRY : GSM_PROBE_INTERVAL);
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_Recover()
+ * @brief	This function restarts the modem which stopped answering, with the PWRKEY, and brings it up again
+ * @param  	None
+ * @retval	None
+ * @note	Blocks till the modem is up, about GSM_RECOVERY_TIMEOUT at most. Power state of the hung modem is not
+ *			known, so the PWRKEY is pulsed till the modem answers, at most GSM_POWER_MAX_PULSES times. If it never
+ *			answers, it is tried again after GSM_PROBE_INTERVAL. Network is waited for only in the time left,
+ *			+CREG and the signal sampling tell when it is registered later.
+ *			PWRKEY shares the port with the software UART pins, GPIO_Write() is atomic against its ISR.
+ *			Messages received while the modem was hung are listed, not purged as after the reset.
+ *			Count and time of the recoveries are reported with GET RECOVERY.
+ */
+static void GSM_Recover()
+{
+	uint32_t start = TIMER_GetTicks();
+	uint32_t deadline;
+	uint32_t elapsed;
+	uint8_t pulses;
+	uint8_t answered = 0xFF;
+
+	DEBUG_TRACE("<modem hung, restarting>\r\n");
+	USART_SetBaudRate(USART_BASE_BAUD_RATE, USART_BASE_MODE);	// Modem starts again with the base baud rate
+
+	for(pulses = 0; (pulses < GSM_POWER_MAX_PULSES) && (answered != 0x00); pulses++)
+	{
+		GSM_PowerKeyPulse();
+		deadline = TIMER_GetTicks() + GSM_POWER_ON_WAIT;
+		while((answered != 0x00) && (!TIMER_Expired(deadline)))
+			answered = GSM_TestForResponse();
+	}
+
+	gProbeFailures = 0;
+	gProbeDeadline = TIMER_GetTicks() + GSM_PROBE_INTERVAL;
+
+	if(answered != 0x00)
+	{
+		gRecoveryFailures++;
+	}
+	else
+	{
+		elapsed = TIMER_GetTicks() - start;
+		GSM_BringUp((elapsed < GSM_RECOVERY_TIMEOUT) ? (GSM_RECOVERY_TIMEOUT - elapsed) : 0);
+		gStoragePurge = 0;
+		gPendingMessage = 1;
+
+		gRecoveries++;
+		gRecoveryLast = TIMER_GetTicks() - start;
+		gRecoveryTotal += gRecoveryLast;
+	}
+
+	GSM_TRACE_STATUS("<recovery: %s>\r\n", RECOVERY_REPORT);
+}
+#endif	//USE_MODEM_WATCHDOG
+
+/*
+ * @name   	GSM_SignalQueried()
+ * @brief	Callback of AT+CSQ, queued after AT+CREG? while idle
+ * @param  	status - status of AT+CSQ
+ * @retval	None
+ * @note	Current, minimum and average <rssi> are kept for GET SIGNAL, see GSM_SignalReport().
+ *			Unknown <rssi> (99) is reported but not taken in the minimum and the average.
+ */
+static void GSM_SignalQueried(uint8_t status)
+{
+	uint8_t lineCount;
+	const USART_LineType* lines = USART_GetLines(&lineCount);
+	uint8_t i;
+	uint8_t rssi;
+
+	gSignalDeadline = TIMER_GetTicks() + (GSM_NETWORK_REGISTERED(gNetworkStatus) ? GSM_SIGNAL_INTERVAL : GSM_SIGNAL_RETRY);
+	gGSMState = GSM_IDLE;
+
+	if(status != AT_SUCCESS)
+		return;
+
+#if (USE_MODEM_WATCHDOG != 0)
+	//Modem answered, no need to probe it for a while
+	gProbeFailures = 0;
+	gProbeDeadline = TIMER_GetTicks() + GSM_PROBE_INTERVAL;
+#endif	//USE_MODEM_WATCHDOG
+
+	for(i = 0; i < lineCount; i++)
+	{
+		if(compareStrings_P((const char*)&gGSM_Response[lines[i].offset], SIGNAL_RESPONSE) == 0)
+		{
+			rssi = atoi((const char*)&gGSM_Response[lines[i].offset + 6]);	// Skip "+CSQ: "
+			gSignalCurrent = rssi;
+			if(rssi > 31)
+				break;
+
+			if(gSignalMinimum == GSM_SIGNAL_UNKNOWN)
+			{
+				gSignalMinimum = rssi;
+				gSignalAverage = rssi << 3;
+			}
+			else
+			{
+				if(rssi < gSignalMinimum)
+					gSignalMinimum = rssi;
+				gSignalAverage = gSignalAverage - (gSignalAverage >> 3) + rssi;
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * @name   	GSM_SampleSignal()
+ * @brief	This function queues AT+CREG? and AT+CSQ to sample the network, low priority task of the idle state
  * @param  	None
+ * @retval	0x00	- if the commands are queued, GSM_SignalQueried() sets the state back to GSM_IDLE
+ *			0xFF	- if the queue is full
+ */
+static uint8_t GSM_SampleSignal()
+{
+	if(AT_QueueCommand(PSTR("AT+CREG?"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_NetworkQueried))
+		return 0xFF;
+
+	if(AT_QueueCommand(PSTR("AT+CSQ"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_SignalQueried))
+	{
+		gSignalDeadline = TIMER_GetTicks() + GSM_SIGNAL_RETRY;	// Registration is still queried
+		return 0xFF;
+	}
+
+	return 0x00;
+}
+
+/*
+ * @name   	GSM_SetPrimayUser()
+ * @brief	This function will store one of the licensing user as primary user
+ * @param  	number  - phone number of the licensing user
+ * @retval	None
+ * @note
+ */
+void GSM_SetPrimayUser(const char* number)
+{
+	strcpy(gPrimeUser, number);
+	updateEEPROM(PRIMARY_OPERATOR, (uint8_t*)gPrimeUser);
+}
+
+/*
+ * @name   	GSM_RunCommand()
+ * @brief	This function runs the command kept in the flash, ex: command of the key or of the missed call
+ * @param  	command - command in the flash, not longer than DATA_FORMAT_LENGTH
+ * @retval	Status code of the command
+ * @note	gCommand points to the local copy only while the command runs
+ */
+static uint8_t GSM_RunCommand(const char* command)
+{
+	char text[DATA_FORMAT_LENGTH];
+
+	strncpy_P(text, command, DATA_FORMAT_LENGTH - 1);
+	text[DATA_FORMAT_LENGTH - 1] = '\0';
+	gCommand = (uint8_t*)text;
+	gCommandLength = strlen(text);
+
+	return processCommand();
+}
+
+/*
+ * @name   	GSM_MissedCallCommand()
+ * @brief	This function gives the command of the missed call action
+ * @param  	action - character of gMissedCallPattern[]
+ * @retval	Command to run in the flash, NULL if the action is not known
+ */
+static const char* GSM_MissedCallCommand(uint8_t action)
+{
+	uint8_t i = 0;
+
+	while((i < gTotalMissedCallActions) && (pgm_read_byte(&MISSED_CALL_ACTIONS[i].id) != action))
+		i++;
+
+	return (i < gTotalMissedCallActions) ? MISSED_CALL_ACTIONS[i].data : 0;
+}
+
+/*
+ * @name   	GSM_CheckMissedCallPattern()
+ * @brief	This function checks the missed call pattern given with SET MISSED CALL
+ * @param  	pattern - <quick hang up seconds><action of quick hang up><action of 1 ring><action of 2 rings>
+ *			Ex: 3F12 - hang up with in 3 seconds turns OFF all, 1 ring toggles switch 1 and 2 rings toggles switch 2
+ * @retval	0x00 	- if the pattern is valid
+ *			0xFF	- otherwise
+ * @note	Quick hang up seconds 0 disables the quick hang up. Actions are '0' (nothing), '1', '2', 'N' (all ON) and 'F' (all OFF)
+ */
+uint8_t GSM_CheckMissedCallPattern(const uint8_t* pattern)
+{
+	uint8_t i;
+
+	if((strlen((const char*)pattern) != MISSED_CALL_PATTERN_LENGTH) || (pattern[0] < '0') || (pattern[0] > '9'))
+		return 0xFF;
+
+	for(i = 1; i < MISSED_CALL_PATTERN_LENGTH; i++)
+	{
+		if(GSM_MissedCallCommand(pattern[i]) == 0)
+			return 0xFF;
+	}
+
+	return 0x00;
+}
+
+/*
+ * @name   	GSM_CheckValidNumber()
+ * @brief	This function will check whether the number in gUser is a valid user
+ * @param  	None
+ * @retval	0x00 	- if user is autherised user
+ *			0xFF	- otherwise
+ * @note	gFlagPrimaryUser and gFlagLicensingUser are set for the user
+ */
+static uint8_t GSM_CheckValidNumber()
+{
+    uint8_t  retVal = 0xFF;
+
+	gValidUser = 0;
+	DEBUG_TRACE("<user: %s>\r\n", gUser);
+
+	//Compare the number with the valid user list!
+	//if(strcmp((const char*)gUser, gPrimeUser) == 0)
+	gFlagLicensingUser = 0;
+	gFlagPrimaryUser = 0;
+	if((strlen((const char*)gPrimeUser) > 0) && (compareStrings((const char*)gPrimeUser, (const char*)gUser) == 0))
+	{
+		gFlagPrimaryUser = 1;
+		gValidUser = 1;
+		retVal = 0x00;
+	}
+	else if((strlen((const char*)gSecondUser) > 0) && (compareStrings((const char*)gSecondUser, (const char*)gUser) == 0))
+	{
+		gValidUser = 1;
+		retVal = 0x00;
+	}
+	else if((strlen((const char*)gThirdUser) > 0) && (compareStrings((const char*)gThirdUser, (const char*)gUser) == 0))
+	{
+		gValidUser = 1;
+		retVal = 0x00;
+	}
+
+	//Check if the user is a gLicensingUser1
+	if((compareStrings_P((const char*)gUser, gLicensingUser1) == 0) || (compareStrings_P((const char*)gUser, gLicensingUser2) == 0))
+	{
+		gFlagLicensingUser = 1;
+		gValidUser = 1;
+		retVal = 0x00;
+	}
+
+    return retVal;
+}
+
+/*
+ * @name   	GSM_CheckValidUser()
+ * @brief	This function will whether the message or call received from the valid user
+ * @param  	response - response from the GSM module which has the phone number, +CLIP line or AT+CMGR response
+ *			doubelQuoteOccurance - is the occurance of double quote in the response when either call or message is received
+ *			doubelQuoteOccurance == 1 for the call
+ *			doubelQuoteOccurance == 3 for message
+ * @retval	0x00 	- if user is autherised user
+ *			0xFF	- otherwise
+ * @note	This function will look for the occurance of double quote in '"' in the reponse. and get the phone number from there!
+ *			'+' is not present with number then, a '+' will be added in the valid user buffer.
+ *			Response is not changed and nothing is waited for, so it can be called from the +CLIP handler
+ */
+uint8_t GSM_CheckValidUser(uint8_t* response, uint8_t doubelQuoteOccurance)
+{
+	uint8_t i = 0, j = 0;
+	uint8_t count = 0;
+
+	gResponseDetails = response;
+
+	gResponseLength = strlen((const char*)response);
+	count = 0;
+	//find the double quote occurance
+	for(i=1; i<gResponseLength; i++)
+	{
+		if(gResponseDetails[i] == '"')
+			count++;
+
+		if(count == doubelQuoteOccurance)
+			break;
+	}
+
+	//if '+' is not preceeded with the phone number then add +!
+	if((i >= gResponseLength) || (gResponseDetails[i+1] != '+'))
+		gUser[j++] = '+';
+
+	//Now copy the number with '+' sign
+	for(i++; (i < gResponseLength) && (gResponseDetails[i] != '"') && (j < (sizeof(gUser) - 1)); i++, j++)
+		gUser[j] = gResponseDetails[i];
+
+	gUser[j] = '\0';
+
+    return GSM_CheckValidNumber();
+}
+
+/*
+ * @name   	GSM_EndCall()
+ * @brief	This function cuts the call and ends the call session
+ * @param  	None
+ * @retval	None
+ */
+static void GSM_EndCall()
+{
+	AT_QueueUrgent(PSTR("ATH0"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, 0);
+#if (USE_DTMF_CONTROL != 0)
+	gCallSession = 0;
+#endif	//USE_DTMF_CONTROL
+	gRingCount = 0;
+	gGSMState = GSM_IDLE;
+}
+
+#if (USE_DTMF_CONTROL != 0)
+/*
+ * @name   	GSM_SessionReady()
+ * @brief	Callback of AT+DDET=1, keys are taken as commands from now on
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Tone is played, so that the user knows the keys can be pressed
+ */
+static void GSM_SessionReady(uint8_t status)
+{
+	if(gGSMState != GSM_VOICE_CALL)		// Caller has ended the call
+		return;
+
+	if(status != AT_SUCCESS)
+	{
+		GSM_EndCall();
+		return;
+	}
+
+	gCallSession = 1;
+	gSessionDeadline = TIMER_GetTicks() + GSM_CALL_SESSION_TIMEOUT;
+	AT_QueueCommand(PSTR("AT+VTS=%S"), TONE_SUCCESS, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, 0);
+}
+
+/*
+ * @name   	GSM_CallAnswered()
+ * @brief	Callback of ATA
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	DTMF detection is applied at setup, it is applied again only if it is lost
+ */
+static void GSM_CallAnswered(uint8_t status)
+{
+	if(gGSMState != GSM_VOICE_CALL)		// Caller has ended the call
+		return;
+
+	if(status != AT_SUCCESS)
+	{
+		GSM_EndCall();
+		return;
+	}
+
+	GSM_EnsureSetting(GSM_SETTING_DTMF, GSM_SessionReady);
+}
+
+/*
+ * @name   	GSM_KeyReceived()
+ * @brief	Handler of +DTMF, runs the command of the key and plays the tone for the status
+ * @param  	line - +DTMF: <key>
+ * @retval	None
+ * @note	Tone is TONE_SUCCESS for the success or switch ON, TONE_STATUS_OFF for switch OFF and TONE_FAILED otherwise.
+ *			'#' ends the call. Acknowledgement message is not sent for the keys, tone is the acknowledgement.
+ */
+static void GSM_KeyReceived(const char* line)
+{
+	uint8_t i = 0;
+	uint8_t code = FAILED;
+	const char* tone = TONE_FAILED;
+
+	if((!gCallSession) || (gGSMState != GSM_VOICE_CALL))
+		return;
+
+	if(line[7] == '#')	// Skip "+DTMF: "
+	{
+		GSM_EndCall();
+		return;
+	}
+
+	while((i < gTotalDTMFKeys) && (pgm_read_byte(&DTMF_KEYS[i].id) != (uint8_t)line[7]))
+		i++;
+
+	if(i < gTotalDTMFKeys)
+	{
+		code = GSM_RunCommand(DTMF_KEYS[i].data);
+		DEBUG_TRACE("<key %c: %d>\r\n", line[7], code);
+	}
+
+	if(code == STATUS_OFF)
+		tone = TONE_STATUS_OFF;
+	else if((code == SUCCESSFUL) || (code == STAUTS_ON) || (code == SUCCESSFULLY_SWITCHED_ON) || (code == SUCCESSFULLY_SWITCHED_OFF))
+		tone = TONE_SUCCESS;
+
+	gSessionDeadline = TIMER_GetTicks() + GSM_CALL_SESSION_TIMEOUT;
+	AT_QueueCommand(PSTR("AT+VTS=%S"), tone, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, 0);
+}
+#endif	//USE_DTMF_CONTROL
+
+/*
+ * @name   	GSM_PlayAudio()
+ * @brief	This function will play audio option for the user
+ * @param  	None
+ * @retval	None
+ * @note	Call is answered and the keys pressed are taken as commands, see DTMF_KEYS[].
+ *			Without USE_DTMF_CONTROL, call is cut.
+ */
+void GSM_PlayAudio()
+{
+#if (USE_DTMF_CONTROL != 0)
+	if(AT_QueueCommand(PSTR("ATA"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_CallAnswered) == 0x00)
+		return;
+#endif	//USE_DTMF_CONTROL
+
+	GSM_EndCall();
+}
+
+/*
+ * @name   	GSM_RingReceived()
+ * @brief	Handler of RING
+ * @param  	line - RING line
+ * @retval	None
+ * @note	In GSM_IDLE, call is started and caller is checked with the +CLIP that follows.
+ *			Ring count is incremented for every RING from the valid user.
+ *			If gMaxRingWait count is reached it will accept the call and play the audio option.
+ *			Count stops at gMaxRingWait, so that the call is answered only once.
+ *			RING received while the previous request is processed is ignored, call is taken with the next RING
+ */
+static void GSM_RingReceived(const char* line)
+{
+	if(gGSMState == GSM_IDLE)
+	{
+		gRingCount = 0;
+		gCallStart = TIMER_GetTicks();
+		gGSMState = GSM_VOICE_CALL;
+	}
+	else if((gGSMState == GSM_VOICE_CALL) && (gRingCount != 0))
+	{
+		if(gRingCount < gMaxRingWait)
+		{
+			gRingCount++;
+			if(gRingCount >= gMaxRingWait)
+				GSM_PlayAudio();
+		}
+	}
+}
+
+/*
+ * @name   	GSM_CallerReceived()
+ * @brief	Handler of +CLIP, checks the caller once per call
+ * @param  	line - +CLIP: "<number>",<type>,... received with every RING
+ * @retval	None
+ * @note	If caller is not valid, call is cut right away with ATH0 in front of the queue.
+ *			While a chain of commands is running, only the invalid callers are cut. Call from the valid user
+ *			is taken with the RING after the chain is complete.
+ */
+static void GSM_CallerReceived(const char* line)
+{
+	if(((gGSMState != GSM_VOICE_CALL) && (gGSMState != GSM_WAITING)) || (gRingCount != 0))
+		return;
+
+	if(gDeviceLicensed && (!GSM_CheckValidUser((uint8_t*)line, 1)))		// 1st occurance of double quote
+	{
+		if(gGSMState == GSM_VOICE_CALL)
+		{
+			gRingCount = 1;		// Missed call can be taken from now on
+			if(gRingCount >= gMaxRingWait)
+				GSM_PlayAudio();
+		}
+		return;
+	}
+
+	AT_QueueUrgent(PSTR("ATH0"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, 0);
+	if(gGSMState == GSM_WAITING)
+		return;
+
+#if(USE_DETAILED_RESPONSE != 0)
+	if(!gDeviceLicensed)
+	{
+		gResponseCode = NOT_LICENSED;
+		gGSMState = GSM_WRITE_MESSAGE;
+	}
+	else
+#endif	//USE_DETAILED_RESPONSE
+		gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_CallEnded()
+ * @brief	Handler of NO CARRIER
+ * @param  	line - NO CARRIER line
+ * @retval	None
+ * @note	If the valid user ends the call before gMaxRingWait, gGSMState will be changed to GSM_MISSED_CALL.
+ *			Call which is answered (or being answered) is not a missed call.
+ *			Action is taken from gMissedCallPattern[], by the time from the first RING and the number of rings.
+ */
+static void GSM_CallEnded(const char* line)
+{
+	if(gGSMState != GSM_VOICE_CALL)
+		return;
+
+#if (USE_DTMF_CONTROL != 0)
+	gCallSession = 0;
+#endif	//USE_DTMF_CONTROL
+	if((gRingCount != 0) && (gRingCount < gMaxRingWait))		//Missed call!
+	{
+		if((gMissedCallPattern[0] != '0') && ((TIMER_GetTicks() - gCallStart) < ((uint32_t)(gMissedCallPattern[0] - '0') * 1000)))
+			gMissedCallAction = gMissedCallPattern[1];
+		else
+			gMissedCallAction = gMissedCallPattern[(gRingCount < 2) ? 2 : 3];
+		gGSMState = GSM_MISSED_CALL;
+	}
+	else
+		gGSMState = GSM_IDLE;
+	gRingCount = 0;			// Caller of the next call is checked even while a chain is running
+}
+
+/*
+ * @name   	GSM_MessageReceived()
+ * @brief	Handler of +CMTI, new message is stored in SIM
+ * @param  	line - +CMTI: "SM",<index>
+ * @retval	None
+ * @note	Message is read once the state machine is in GSM_IDLE
+ */
+static void GSM_MessageReceived(const char* line)
+{
+	gPendingMessage = 1;
+	gStorageUsed++;
+}
+
+#if (USE_DIRECT_SMS != 0)
+/*
+ * @name   	GSM_DirectMessageDropped()
+ * @brief	Takes the message line of +CMT when the previous message is not processed yet
+ * @param  	line - message
+ * @retval	None
+ */
+static void GSM_DirectMessageDropped(const char* line)
+{
+	DEBUG_TRACE("<dropped: %s>\r\n", line);
+}
+
+/*
+ * @name   	GSM_DirectMessageBody()
+ * @brief	Takes the message line of +CMT
+ * @param  	line - message
+ * @retval	None
+ * @note	Message is processed once the state machine is in GSM_IDLE
+ */
+static void GSM_DirectMessageBody(const char* line)
+{
+#if (USE_PDU_MODE != 0)
+	//Line is the PDU, header is made with the sender in double quotes as in text mode
+	if(PDU_Decode(line, &gSMS))
+	{
+		DEBUG_TRACE("<pdu: %s>\r\n", line);
+		gDirectPending = 0;
+		return;
+	}
+	strcpy_P((char*)gDirectHeader, PSTR("+CMT: \""));
+	strcat((char*)gDirectHeader, (const char*)gSMS.sender);
+	strcat_P((char*)gDirectHeader, PSTR("\""));
+	line = (const char*)gSMS.data;
+#endif	//USE_PDU_MODE
+	strncpy((char*)gDirectMessage, line, GSM_DIRECT_LENGTH);
+	gDirectMessage[GSM_DIRECT_LENGTH] = '\0';
+	gDirectPending = 0x02;
+}
+#endif	//USE_DIRECT_SMS
+
+/*
+ * @name   	GSM_DirectMessageReceived()
+ * @brief	Handler of +CMT, message delivered without storing it in SIM
+ * @param  	line - +CMT: "<number>","<alpha>","<time stamp>", +CMT: [<alpha>],<length> in PDU mode
+ * @retval	None
+ * @note	Message follows in the next line. Only one message waits to be processed, a message received
+ *			before that is processed is lost. Without USE_DIRECT_SMS the line is only traced
+ */
+static void GSM_DirectMessageReceived(const char* line)
+{
+#if (USE_DIRECT_SMS != 0)
+	if(gDirectPending == 0x02)
+	{
+		AT_CaptureNextLine(GSM_DirectMessageDropped);
+		return;
+	}
+
+	strncpy((char*)gDirectHeader, line, GSM_HEADER_LENGTH);
+	gDirectHeader[GSM_HEADER_LENGTH] = '\0';
+	gDirectPending = 0x01;
+	AT_CaptureNextLine(GSM_DirectMessageBody);
+#else
+	DEBUG_TRACE("<urc: %s>\r\n", line);
+#endif	//USE_DIRECT_SMS
+}
+
+/*
+ * @name   	GSM_NetworkStatusReceived()
+ * @brief	Handler of +CREG, network registration status is changed
+ * @param  	line - +CREG: <stat>
+ * @retval	None
+ */
+static void GSM_NetworkStatusReceived(const char* line)
+{
+	GSM_SetNetworkStatus(GSM_ParseNetworkStatus(line));
+	DEBUG_TRACE("<creg: %d>\r\n", gNetworkStatus);
+}
+
+/*
+ * @name   	GSM_ModuleReady()
+ * @brief	Handler of RDY and +CFUN, GSM module is restarted
+ * @param  	line - RDY or +CFUN: <fun> line
+ * @retval	None
+ */
+static void GSM_ModuleReady(const char* line)
+{
+	DEBUG_TRACE("<urc: %s>\r\n", line);
+	GSM_InvalidateSettings();
+}
+
+//Unsolicited result codes. Has to be sorted by the prefix (ASCII order), see AT_SetURCTable()
+static const Struct_URC URC_TABLE[] PROGMEM =
+{
+	{"+CFUN: ",		GSM_ModuleReady},
+	{"+CLIP: ",		GSM_CallerReceived},
+	{"+CMT: ",		GSM_DirectMessageReceived},
+	{"+CMTI: ",		GSM_MessageReceived},
+	{"+CREG: ",		GSM_NetworkStatusReceived},
+#if (USE_DTMF_CONTROL != 0)
+	{"+DTMF: ",		GSM_KeyReceived},
+#endif	//USE_DTMF_CONTROL
+	{"NO CARRIER",	GSM_CallEnded},
+	{"RDY",			GSM_ModuleReady},
+	{"RING",		GSM_RingReceived},
+};
+static const uint8_t gTotalURCs = sizeof(URC_TABLE)/sizeof(Struct_URC);
+
+/*
+ * @name   	GSM_ExtractArguement()
+ * @brief	This function extract the arguement 
+ * @param  	uint8_t - lenght of the command which was sent!
+ * @retval	None
+ * @note	This function will extract the arguement from the command captured in gCommand
+ *			Ex of command sent is: SWITCH ON ALL,
+ *			SWITCH ON - is a command
+ *			ALL		  - is an arguement
+ */
+void GSM_ExtractArguement(uint8_t length)
+{
+	uint8_t i;
+	uint8_t size;
+	uint8_t arguementStartPosition;
+	
+	size = (gCommandLength - (length + 1));
+	arguementStartPosition = length + 1;
+	
+	//gResponseDetails += (length + 1);
+	gArguement = (uint8_t *)malloc((sizeof(uint8_t) * size) + 1);
+	//strncpy((char *)gArguement, (const char*)gResponseDetails, (gCommandLength - (length + 1)));
+	for(i = 0; i< size; i++)
+	{
+		gArguement[i] = gCommand[arguementStartPosition + i];
+	}
+	gArguement[i] = '\0';
+}
+
+/*
+ * @name   	GSM_ExecuteCommand()
+ * @brief	This function will do the action of the command from the valid user
+ * @param  	message - command sent in the message, need not be null terminated
+ *			length  - length of the message
+ * @retval	Status code of the action
+ * @note	Command is copied to gCommand, GSM_ExtractArguement() takes the arguement from there
+ */
+static uint8_t GSM_ExecuteCommand(const uint8_t* message, uint8_t length)
+{
+	uint8_t retVal = FAILED;
+	uint8_t i = 0;
+
+	//Extract the gCommand
+	gCommandLength = length;
+	gCommand = (uint8_t *)(malloc((sizeof(uint8_t) * gCommandLength) + 1));
+	for(i = 0; i<gCommandLength ; i++)
+		gCommand[i] = message[i];
+	gCommand[i] = '\0';
+
+	DEBUG_TRACE("<cmd: %s>\r\n", gCommand);
+
+	if((gDeviceLicensed) || ((!gDeviceLicensed) && (!licenseCommand())))
+	{
+		retVal = processCommand();
+	}
+#if(USE_DETAILED_RESPONSE != 0)
+	else
+		retVal = NOT_LICENSED;
+#endif	//USE_DETAILED_RESPONSE
+	if(strlen((const char*)gCommand));
+		free(gCommand);
+
+	return retVal;
+}
+
+#if (USE_PDU_MODE == 0) || (USE_DIRECT_SMS != 0)
+/*
+ * @name   	GSM_ExecuteMessage()
+ * @brief	This function will check the sender of the message and do the action accordingly!
+ * @param  	header  - header of the message which has the phone number of the sender
+ *			doubelQuoteOccurance - occurance of double quote before the phone number in the header
+ *			message - command sent in the message, need not be null terminated
+ *			length  - length of the message
+ * @retval	Status code of the action
+ */
+static uint8_t GSM_ExecuteMessage(uint8_t* header, uint8_t doubelQuoteOccurance, const uint8_t* message, uint8_t length)
+{
+	uint8_t retVal = FAILED;
+
+	if(!GSM_CheckValidUser(header, doubelQuoteOccurance))
+	{
+		DEBUG_TRACE("<msg: %s>\r\n", header);
+		retVal = GSM_ExecuteCommand(message, length);
+	}
+#if(USE_DETAILED_RESPONSE != 0)
+	else
+		retVal = INVALID_USER;
+#endif	//USE_DETAILED_RESPONSE
+
+	return retVal;
+}
+#endif	//USE_PDU_MODE, USE_DIRECT_SMS
+
+#if (USE_PDU_MODE != 0)
+/*
+ * @name   	GSM_ExecutePDU()
+ * @brief	This function will decode the message in PDU, check the sender and do the action accordingly!
+ * @param  	hex - PDU line of the message
+ * @retval	Status code of the action
+ * @note	Sender is taken from the PDU, not searched with the double quotes
+ */
+static uint8_t GSM_ExecutePDU(const char* hex)
+{
+	uint8_t retVal = FAILED;
+
+	gValidUser = 0;
+	if(PDU_Decode(hex, &gSMS))
+	{
+		DEBUG_TRACE("<pdu: %s>\r\n", hex);
+		return retVal;
+	}
+
+	strncpy((char*)gUser, (const char*)gSMS.sender, sizeof(gUser) - 1);
+	gUser[sizeof(gUser) - 1] = '\0';
+
+	if(!GSM_CheckValidNumber())
+		retVal = GSM_ExecuteCommand(gSMS.data, gSMS.length);
+#if(USE_DETAILED_RESPONSE != 0)
+	else
+		retVal = INVALID_USER;
+#endif	//USE_DETAILED_RESPONSE
+
+	return retVal;
+}
+#endif	//USE_PDU_MODE
+
+/*
+ * @name   	GSM_QueueAcknowledgement()
+ * @brief	This function will queue the acknowledgement of the request to the user
+ * @param  	code - status code of the request
+ * @retval	0x00 - if acknowledgement is queued
+ *			0xFF - if acknowledgement is not needed or the queue is full
+ * @note	DEVICE_ON goes to the primary user, other status codes to the user who sent the request (gUser).
+ *			Status code is merged into the waiting acknowledgement of the same user, if the message stays with in
+ *			GSM_ACK_LENGTH. Acknowledgement which is being sent is not changed.
+ */
+static uint8_t GSM_QueueAcknowledgement(uint8_t code)
+{
+	Struct_Acknowledgement *ack;
+	const uint8_t* number;
+	char text[GSM_REPORT_LENGTH] = "";
+	uint8_t length;
+	uint8_t i;
+
+	if((gValidUser == 0) && ((strlen((const char*)gPrimeUser) == 0) || (code != DEVICE_ON)))
+		return 0xFF;
+
+	number = (code == DEVICE_ON) ? (const uint8_t*)gPrimeUser : gUser;
+	GSM_AppendStatus(text, sizeof(text), code);
+	length = strlen(text);
+
+	for(i = gAckTail + gAckSending; i != gAckHead; i++)
+	{
+		ack = &gAckQueue[i & GSM_ACK_QUEUE_MASK];
+		if((strcmp((const char*)ack->number, (const char*)number) == 0) && (ack->count < GSM_ACK_MAX_CODES)
+			&& ((ack->length + 2 + length) <= GSM_ACK_LENGTH))
+		{
+			ack->codes[ack->count++] = code;
+			ack->length += 2 + length;
+			return 0x00;
+		}
+	}
+
+	if((uint8_t)(gAckHead - gAckTail) >= GSM_ACK_QUEUE_LENGTH)
+	{
+		DEBUG_TRACE("<ack dropped: %d>\r\n", code);
+		return 0xFF;
+	}
+
+	ack = &gAckQueue[gAckHead & GSM_ACK_QUEUE_MASK];
+	ack->codes[0] = code;
+	ack->count = 1;
+	ack->length = length;
+	strncpy((char*)ack->number, (const char*)number, sizeof(ack->number) - 1);
+	ack->number[sizeof(ack->number) - 1] = '\0';
+	gAckHead++;
+
+	return 0x00;
+}
+
+/*
+ * @name   	GSM_SlotDeleted()
+ * @brief	Callback of AT+CMGD in the cleanup
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	If in some cases deleting message fails, retry for maximum allowed number of times.
+ *			Message which could not be deleted is read with AT+CMGR, so that it is marked as read and not listed again.
+ *			It is deleted by the purge when the storage is full.
+ */
+static void GSM_SlotDeleted(uint8_t status)
+{
+	if(status == AT_SUCCESS)
+	{
+		if(gStorageUsed)
+			gStorageUsed--;
+	}
+	else
+	{
+		DEBUG_TRACE("<del %s: %s>\r\n", gDeleteIndex, gGSM_Response);
+
+		gDeleteCount++;
+		if(gDeleteCount < gDeleteRetries)
+		{
+			AT_QueueCommand(PSTR("AT+CMGD=%s"), (const char*)gDeleteIndex, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_SlotDeleted);
+			return;
+		}
+		AT_QueueCommand(PSTR("AT+CMGR=%s"), (const char*)gDeleteIndex, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, 0);
+	}
+
+	gProcessedSlots[gDeleteSlot >> 3] &= ~(1 << (gDeleteSlot & 0x07));
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_StorageQueried()
+ * @brief	Callback of AT+CPMS? and of the purge
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Response is +CPMS: "SM",<used>,<total>,"SM",<used>,<total>,"SM",<used>,<total>. First storage is read.
+ */
+static void GSM_StorageQueried(uint8_t status)
+{
+	uint8_t lineCount;
+	const USART_LineType* lines = USART_GetLines(&lineCount);
+	const char* details;
+
+	if((status == AT_SUCCESS) && (lineCount > 1) && (compareStrings_P((const char*)&gGSM_Response[lines[0].offset], STORAGE_RESPONSE) == 0))
+	{
+		details = strchr((const char*)&gGSM_Response[lines[0].offset], ',');
+		if(details)
+		{
+			gStorageUsed = atoi(details + 1);
+			details = strchr(details + 1, ',');
+			if(details)
+				gStorageTotal = atoi(details + 1);
+			gStorageStale = 0;
+
+			//Purge of the read messages freed nothing, storage is full of unread ones. They are listed, not purged again
+			if(gPurgeUsed && (gStorageUsed >= gPurgeUsed))
+			{
+				gPurgeDeadline = TIMER_GetTicks() + GSM_PURGE_BACKOFF;
+				gPendingMessage = 1;
+			}
+			gPurgeUsed = 0;
+		}
+		DEBUG_TRACE("<storage: %d/%d>\r\n", gStorageUsed, gStorageTotal);
+	}
+
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_StoragePurged()
+ * @brief	Callback of AT+CMGDA="DEL ALL", queued once after the bring up
+ * @param  	status - status of the command
  * @retval	None
- * @note	This function will look for the id number in the OPERATIONS[]. and responds the ack message to Primery user.
+ * @note	Purge is tried gDeleteRetries times, after that the messages are left to the cleanup
+ */
+static void GSM_StoragePurged(uint8_t status)
+{
+	if(status == AT_SUCCESS)
+	{
+		gStoragePurge = 0;
+		gStorageUsed = 0;
+		memset(gProcessedSlots, 0, sizeof(gProcessedSlots));
+	}
+	else
+	{
+		DEBUG_TRACE("<del: %s>\r\n", gGSM_Response);
+		gStoragePurge--;
+	}
+	gStorageStale = 1;
+
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_StorageCleanup()
+ * @brief	This function queues one step of the SIM storage cleanup
+ * @param  	urgent - 0x01 if the storage is needed right now, 0x00 if it can wait till there is nothing else to do
+ * @retval	0x00 - if a command is queued, gGSMState is changed to GSM_IDLE once it is complete
+ *			0xFF - if nothing is to be done
+ * @note	Processed messages are deleted one at a time with AT+CMGD. Storage is queried with AT+CPMS? when not known.
+ *			If the storage is full even after deleting all the processed messages, read messages are purged. Storage
+ *			is queried right after the purge. If it freed nothing, messages are listed and the purge waits for
+ *			GSM_PURGE_BACKOFF, so that the idle state is not held by the purge.
  */
-void GSM_AcknowledgeService()
+static uint8_t GSM_StorageCleanup(uint8_t urgent)
 {
+	uint8_t slot = 0;
 	uint8_t i;
 
-	if((gValidUser != 0) || ((strlen((const char*)gPrimeUser) > 0) && (gResponseCode == DEVICE_ON)))
+	//Lowest processed slot first
+	do
 	{
-		if(GSM_SendRequest("AT+CMGF=1", OK_RESPONSE) == 0x00)
+		if(gProcessedSlots[slot >> 3] & (1 << (slot & 0x07)))
 		{
-			USART_FlushReceiveBuffer();
-			_delay_ms(500);
-			
-			if(gResponseCode == DEVICE_ON)
-				print("at+cmgs=\"%s\"\r\n", gPrimeUser);
-			else
-				print("at+cmgs=\"%s\"\r\n", gUser);
-			
-			if((!GSM_ReceiveWait()) && (gGSM_Response[0] == 0x3E))	// 0x3E == '>' indicating to compose message to be sent from GSM module
+			gDeleteSlot = slot;
+			gDeleteCount = 0;
+
+			//Index as text for AT+CMGD
+			i = 0;
+			if(slot >= 100)
+				gDeleteIndex[i++] = '0' + (slot / 100);
+			if(slot >= 10)
+				gDeleteIndex[i++] = '0' + ((slot / 10) % 10);
+			gDeleteIndex[i++] = '0' + (slot % 10);
+			gDeleteIndex[i] = '\0';
+
+			return AT_QueueCommand(PSTR("AT+CMGD=%s"), (const char*)gDeleteIndex, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_SlotDeleted);
+		}
+		slot++;
+	}while(slot != 0);
+	gCleanupUrgent = 0;
+
+	if(GSM_STORAGE_FULL() && (!gStorageStale) && TIMER_Expired(gPurgeDeadline))
+	{
+		gStorageStale = 1;		// Query again after the purge
+		gPurgeUsed = gStorageUsed;
+		return AT_QueueCommand(PSTR("AT+CMGDA=\"DEL READ\""), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_StorageQueried);
+	}
+
+	if(gStorageStale && ((!urgent) || gPurgeUsed))
+		return AT_QueueCommand(PSTR("AT+CPMS?"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_StorageQueried);
+
+	return 0xFF;
+}
+
+/*
+ * @name   	GSM_MessagesListed()
+ * @brief	Callback of AT+CMGL, executes the listed messages in the order of the list
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Each message is a header line +CMGL: <index>,"REC UNREAD","<number>",... and a message line.
+ *			In PDU mode header is +CMGL: <index>,<stat>,,<length> and the message line is the PDU.
+ *			Message line is kept by the AT engine as it is, a message "OK" or "ERROR" does not end the list.
+ *			Status of the messages is not changed by the list (mode 1 of AT+CMGL), so the processed messages are
+ *			listed till they are deleted. They are remembered in gProcessedSlots[] and skipped.
+ *			If the list did not fit in gGSM_Response, messages are listed again. When the processed messages
+ *			are in the way, they are deleted before that. Message line which does not fit even at the start of
+ *			gGSM_Response is never executed, it is taken as processed so that it is deleted and not listed again.
+ *			In text mode its sender gets INVALID_COMMAND (FAILED without USE_DETAILED_RESPONSE) as acknowledgement.
+ */
+static void GSM_MessagesListed(uint8_t status)
+{
+	uint8_t i;
+	uint8_t lineCount;
+	uint8_t code;
+	uint8_t slot;
+	uint8_t processed = 0;
+	uint8_t skipped = 0;
+	uint8_t incomplete = 0;
+	uint8_t* header;
+	const USART_LineType* lines = USART_GetLines(&lineCount);
+
+	if(status == AT_SUCCESS)
+	{
+		if(lineCount >= USART_MAX_LINES)
+			incomplete = 1;
+
+		//Last line is the final response, message line has to be there after the header
+		for(i = 0; (i + 2) < lineCount; i++)
+		{
+			header = &gGSM_Response[lines[i].offset];
+			if(lines[i + 1].length == 0)
 			{
-				USART_FlushReceiveBuffer();
+				//Message line is dropped as it did not fit. After the other lines it can fit in the next list,
+				//right after the first header it never does
+				if((lines[i].offset == 0) && (compareStrings_P((const char*)header, MESSAGE_LIST_RESPONSE) == 0))
+				{
+					slot = atoi((const char*)&header[7]);	// Skip "+CMGL: "
+					gProcessedSlots[slot >> 3] |= (1 << (slot & 0x07));
+					processed++;
+					DEBUG_TRACE("<msg %d too long>\r\n", slot);
+#if (USE_PDU_MODE == 0)
+					//Sender is told that the command is not done. In PDU mode the number is in the dropped line
+					if(gServiceAcknowledgement && (!GSM_CheckValidUser(header, 3)))		// 3rd occurance of double quote
+	#if(USE_DETAILED_RESPONSE != 0)
+						GSM_QueueAcknowledgement(INVALID_COMMAND);
+	#else	//USE_DETAILED_RESPONSE
+						GSM_QueueAcknowledgement(FAILED);
+	#endif	//USE_DETAILED_RESPONSE
+#endif	//USE_PDU_MODE
+				}
+				else
+					incomplete = 1;		// Message is left unread for the next list
+				continue;
+			}
 
-				i = 0;
-				while((i<totalNumberOfStatusCodes) && (STATUS_CODE[i].id != gResponseCode))
-					i++;
-				if(i<totalNumberOfStatusCodes)
-					print("%s", STATUS_CODE[i].data);
+			if(compareStrings_P((const char*)header, MESSAGE_LIST_RESPONSE) != 0)
+				continue;
 
-				//Special Character Ctrl+Z to be sent to close the message
-				USART_PutChar(Ctrl_Z); //26 in Decimal
+			slot = atoi((const char*)&header[7]);	// Skip "+CMGL: "
+			if(gProcessedSlots[slot >> 3] & (1 << (slot & 0x07)))
+			{
+				skipped++;
+				code = 0xFF;	// Not executed again
+			}
+			else
+			{
+#if (USE_PDU_MODE != 0)
+				code = GSM_ExecutePDU((const char*)&gGSM_Response[lines[i + 1].offset]);
+#else
+				//Line after the header is the message, unless it is the next header
+				if(compareStrings_P((const char*)&gGSM_Response[lines[i + 1].offset], MESSAGE_LIST_RESPONSE) != 0)
+					code = GSM_ExecuteMessage(header, 3, &gGSM_Response[lines[i + 1].offset], lines[i + 1].length);	// 3rd occurance of double quote
+				else
+					code = GSM_ExecuteMessage(header, 3, (const uint8_t*)"", 0);
+#endif	//USE_PDU_MODE
 
-				GSM_ReceiveWait();
+				gProcessedSlots[slot >> 3] |= (1 << (slot & 0x07));
+				processed++;
 
-				_delay_ms(1000);//Delay is necessary
+				if(gServiceAcknowledgement)
+					GSM_QueueAcknowledgement(code);
 			}
-			
-			//Special Character Ctrl+Z to be sent to close the message
-			/*USART_PutChar(Ctrl_Z); //26 in Decimal
 
-			GSM_ReceiveWait();
+			if(compareStrings_P((const char*)&gGSM_Response[lines[i + 1].offset], MESSAGE_LIST_RESPONSE) != 0)
+				i++;
+		}
+	}
+
+	if(incomplete)
+	{
+		if(processed || skipped)
+			gPendingMessage = 1;
+		if(!processed && skipped)
+			gCleanupUrgent = 1;
+	}
+
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_ListFormatSet()
+ * @brief	Callback of AT+CMGF in the read message chain
+ * @param  	status - status of the command
+ * @retval	None
+ */
+static void GSM_ListFormatSet(uint8_t status)
+{
+	if(status != AT_SUCCESS)
+		gGSMState = GSM_IDLE;
+#if (USE_PDU_MODE != 0)
+	else
+		AT_QueueCommand(PSTR("AT+CMGL=0,1"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_MessagesListed);	// 0 - REC UNREAD
+#else
+	else
+		AT_QueueCommand(PSTR("AT+CMGL=\"REC UNREAD\",1"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_MessagesListed);
+#endif	//USE_PDU_MODE
+}
+
+/*
+ * @name   	GSM_ProcessMessage()
+ * @brief	This function will queue the listing and processing of all the unread messages
+ * @param  	None
+ * @retval	None
+ * @note	Chain is AT+CMGF=1, AT+CMGL="REC UNREAD",1 and AT+CMGD for each processed message.
+ *			With USE_PDU_MODE, it is AT+CMGF=0 and AT+CMGL=0,1. AT+CMGF is sent only if the format is not applied.
+ *			Once the messages are deleted gGSMState is changed to GSM_IDLE, acknowledgements are sent from there.
+ */
+static void GSM_ProcessMessage()
+{
+	GSM_EnsureSetting(GSM_SETTING_SMS_FORMAT, GSM_ListFormatSet);
+}
+
+/*
+ * @name   	GSM_AcknowledgeDone()
+ * @brief	Callback of the last command in the acknowledgement chain, or of the failed one
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	+CMGS: <mr> and OK are received once the message is sent to network. Acknowledgement is not retried.
+ *			Status codes which did not fit in the message are left at gAckTail, they are sent as the next message.
+ */
+static void GSM_AcknowledgeDone(uint8_t status)
+{
+	Struct_Acknowledgement *ack = &gAckQueue[gAckTail & GSM_ACK_QUEUE_MASK];
+
+	gAckSending = 0;
+	if((status == AT_SUCCESS) && (gAckCodesSent < ack->count))
+	{
+		ack->count -= gAckCodesSent;
+		memmove(ack->codes, &ack->codes[gAckCodesSent], ack->count);
+		ack->length = GSM_ACK_LENGTH;		// Nothing more is merged into the rest
+	}
+	else
+		gAckTail++;
+	gGSMState = GSM_IDLE;
+}
+
+/*
+ * @name   	GSM_AcknowledgePrompt()
+ * @brief	Callback of AT+CMGS, sends the message body once '>' is received
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Message body is closed with special character Ctrl+Z
+ */
+static void GSM_AcknowledgePrompt(uint8_t status)
+{
+	if(status != AT_SUCCESS)
+	{
+		GSM_AcknowledgeDone(status);
+		return;
+	}
+
+#if (USE_PDU_MODE != 0)
+	AT_QueueUrgent(PSTR("%s"), gAckPDU, AT_END_MESSAGE, OK_RESPONSE, GSM_SEND_MESSAGE_TIMEOUT, GSM_AcknowledgeDone);	// Modem is waiting for the PDU
+#else
+	AT_QueueUrgent(PSTR("%s"), (const char*)gAckBody, AT_END_MESSAGE, OK_RESPONSE, GSM_SEND_MESSAGE_TIMEOUT, GSM_AcknowledgeDone);	// Modem is waiting for the body
+#endif	//USE_PDU_MODE
+}
+
+/*
+ * @name   	GSM_AcknowledgeFormatSet()
+ * @brief	Callback of AT+CMGF in the acknowledgement chain
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Length of the status texts is checked again, they can be longer than when they were merged (ex: reports).
+ *			Codes which do not fit in GSM_ACK_LENGTH are left for the next message, a single long text is cut.
+ */
+static void GSM_AcknowledgeFormatSet(uint8_t status)
+{
+	uint8_t i;
+	uint8_t length = 0;
+	uint8_t size;
+	char text[GSM_REPORT_LENGTH];
+	Struct_Acknowledgement *ack = &gAckQueue[gAckTail & GSM_ACK_QUEUE_MASK];
+
+	if(status != AT_SUCCESS)
+	{
+		GSM_AcknowledgeDone(status);
+		return;
+	}
+
+	//Status texts of the merged codes, separated by "; "
+	for(i = 0; i < ack->count; i++)
+	{
+		text[0] = '\0';
+		GSM_AppendStatus(text, sizeof(text), ack->codes[i]);
+		size = strlen(text);
+		if(i > 0)
+		{
+			if((length + 2 + size) > GSM_ACK_LENGTH)
+				break;
+			gAckBody[length++] = ';';
+			gAckBody[length++] = ' ';
+		}
+		else if(size > GSM_ACK_LENGTH)
+			size = GSM_ACK_LENGTH;
+		memcpy(&gAckBody[length], text, size);
+		length += size;
+	}
+	gAckBody[length] = '\0';
+	gAckCodesSent = i;
+
+#if (USE_PDU_MODE != 0)
+	//AT+CMGS takes the length of the PDU, without the SMSC
+	i = PDU_Encode((const char*)ack->number, gAckBody, gAckPDU, GSM_ACK_LENGTH);
+	gAckLength[0] = '0' + (i / 100);
+	gAckLength[1] = '0' + ((i / 10) % 10);
+	gAckLength[2] = '0' + (i % 10);
+	gAckLength[3] = '\0';
+
+	//'>' is received to compose message to be sent from GSM module
+	AT_QueueCommand(PSTR("AT+CMGS=%s"), (const char*)gAckLength, AT_END_LINE, ">", GSM_RESPONSE_TIMEOUT, GSM_AcknowledgePrompt);
+#else
+	//'>' is received to compose message to be sent from GSM module
+	AT_QueueCommand(PSTR("AT+CMGS=\"%s\""), (const char*)ack->number, AT_END_LINE, ">", GSM_RESPONSE_TIMEOUT, GSM_AcknowledgePrompt);
+#endif	//USE_PDU_MODE
+}
+
+/*
+ * @name   	GSM_OperatorOf()
+ * @brief	This function finds the operator of the phone number
+ * @param  	number - phone number
+ * @retval	OPERATOR_PRIMARY, OPERATOR_SECOND or OPERATOR_THIRD, 0 if the number is not in the operator list
+ */
+static uint8_t GSM_OperatorOf(const uint8_t* number)
+{
+	if((strlen(gPrimeUser) > 0) && (strcmp(gPrimeUser, (const char*)number) == 0))
+		return OPERATOR_PRIMARY;
+	if((strlen(gSecondUser) > 0) && (strcmp(gSecondUser, (const char*)number) == 0))
+		return OPERATOR_SECOND;
+	if((strlen(gThirdUser) > 0) && (strcmp(gThirdUser, (const char*)number) == 0))
+		return OPERATOR_THIRD;
+
+	return 0;
+}
+
+/*
+ * @name   	GSM_UserOperator()
+ * @brief	This function finds the operator who sent the request being processed
+ * @param  	None
+ * @retval	OPERATOR_xxx, 0 if the user is not in the operator list (ex: licensing user)
+ */
+uint8_t GSM_UserOperator()
+{
+	return GSM_OperatorOf(gUser);
+}
+
+/*
+ * @name   	GSM_RingBackCalls()
+ * @brief	This function gives the number of ring back calls for the status codes of the acknowledgement
+ * @param  	ack - acknowledgement
+ * @retval	1 if all are success, 2 if any is failure, 0 if any status has information which needs the message
+ */
+static uint8_t GSM_RingBackCalls(const Struct_Acknowledgement* ack)
+{
+	uint8_t calls = 1;
+	uint8_t i;
+
+	for(i = 0; i < ack->count; i++)
+	{
+		switch(ack->codes[i])
+		{
+			case SUCCESSFUL:
+			case SUCCESSFULLY_SWITCHED_OFF:
+			case SUCCESSFULLY_SWITCHED_ON:
+				break;
+
+			case DEVICE_ON:
+			case STAUTS_ON:
+			case STATUS_OFF:
+			case SERVICE_NEEDED:
+			case LICENSE_INFO:
+			case ALREADY_LICENSED:
+			case VERSION_NUMBER:
+			case BOOT_TIME:
+#if (USE_MODEM_WATCHDOG != 0)
+			case RECOVERY_REPORT:
+#endif	//USE_MODEM_WATCHDOG
+			case SIGNAL_REPORT:
+				return 0;
 
-			_delay_ms(1000);//Delay is necessary*/
+			default:
+				calls = 2;
+				break;
 		}
 	}
+
+	return calls;
+}
+
+/*
+ * @name   	GSM_RingBackCut()
+ * @brief	Callback of ATH of the ring back call
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Next call is made after GSM_RINGBACK_GAP, acknowledgement is done after the last call
+ */
+static void GSM_RingBackCut(uint8_t status)
+{
+	gRingBackCalls--;
+	if(gRingBackCalls == 0)
+	{
+		GSM_AcknowledgeDone(status);
+		return;
+	}
+
+	gRingBackRinging = 0x00;
+	gRingBackDeadline = TIMER_GetTicks() + GSM_RINGBACK_GAP;
+}
+
+/*
+ * @name   	GSM_RingBackDialed()
+ * @brief	Callback of ATD of the ring back call
+ * @param  	status - status of the command
+ * @retval	None
+ * @note	Call is cut by GSM_RingBackStep() after GSM_RINGBACK_TIME. It doesn't matter if the user picks up or rejects the call.
+ */
+static void GSM_RingBackDialed(uint8_t status)
+{
+	if(status != AT_SUCCESS)
+	{
+		gRingBackCalls = 0;
+		GSM_AcknowledgeDone(status);
+		return;
+	}
+
+	gRingBackRinging = 0x01;
+	gRingBackDeadline = TIMER_GetTicks() + GSM_RINGBACK_TIME;
+}
+
+/*
+ * @name   	GSM_RingBackStep()
+ * @brief	This function cuts the ring back call or makes the next one, once the time is up
+ * @param  	None
+ * @retval	None
+ * @note	Called from the main loop in GSM_WAITING, nothing is done till gRingBackDeadline
+ */
+static void GSM_RingBackStep()
+{
+	if((gRingBackCalls == 0) || (!AT_IsIdle()) || (!TIMER_Expired(gRingBackDeadline)))
+		return;
+
+	if(gRingBackRinging)
+		AT_QueueCommand(PSTR("ATH0"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_RingBackCut);
+	else
+		AT_QueueCommand(PSTR("ATD%s;"), (const char*)gAckQueue[gAckTail & GSM_ACK_QUEUE_MASK].number, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_RingBackDialed);
+	gRingBackDeadline = TIMER_GetTicks() + GSM_SEND_MESSAGE_TIMEOUT;	// Not again till the callback
+}
+
+/*
+ * @name   	GSM_AcknowledgeService()
+ * @brief	This function will send the oldest acknowledgement in the queue
+ * @param  	None
+ * @retval	None
+ * @note	Status texts of the merged status codes are sent as one message, separated by "; ".
+ *			Chain is AT+CMGF=1 (only if text mode is not applied), AT+CMGS and the message body.
+ *			With USE_PDU_MODE, body is encoded as SMS-SUBMIT and AT+CMGS takes the length of the PDU.
+ *			For the operators in gAckByCall, it is ATD and ATH once for success and twice for failure (GSM_RingBackStep()).
+ *			gGSMState has to be GSM_WAITING before calling, it is changed to GSM_IDLE once the message is sent
+ */
+static void GSM_AcknowledgeService()
+{
+	Struct_Acknowledgement *ack = &gAckQueue[gAckTail & GSM_ACK_QUEUE_MASK];
+
+	gAckSending = 1;	// No more status codes are merged into it
+	gAckCodesSent = ack->count;
+
+	//Operators who asked for ACK CALL are acknowledged with ring back calls, when the status needs no text
+	if((gAckByCall & GSM_OperatorOf(ack->number)) && GSM_RingBackCalls(ack))
+	{
+		gRingBackCalls = GSM_RingBackCalls(ack);
+		gRingBackRinging = 0x00;
+		gRingBackDeadline = TIMER_GetTicks();		// First call right away
+		return;
+	}
+
+	GSM_EnsureSetting(GSM_SETTING_SMS_FORMAT, GSM_AcknowledgeFormatSet);
 }
 
 /*
@@ -542,73 +2367,127 @@ void GSM_AcknowledgeService()
  * @brief	This function will handle the state machine of the GSM module!
  * @param  	None
  * @retval	None
- * @note	This function is an infinite loop
- *			Initial state is GSM_IDLE. Here system wait for either a message or call
- *			GSM_VOICE_CALL - Handles the voice call. If user is autherised user. else cut the call and set the state to GSM_IDLE
- *			GSM_MISSED_CALL - If autherised user gives missed call toggle the default switch
+ * @note	This function is an infinite loop, AT command queue is polled in every iteration
+ *			Initial state is GSM_IDLE. Here system wait for either a message or call, and sends the queued acknowledgements
+ *			GSM_VOICE_CALL - Handles the voice call. If user is autherised user, call is answered after gMaxRingWait rings and keys are taken as commands. else cut the call and set the state to GSM_IDLE
+ *			GSM_MISSED_CALL - If autherised user gives missed call, action of the missed call pattern is taken
  *			GSM_READ_MESSAGE - if autherised user sends the message then do appropriate action
- *			GSM_WRITE_MESSAGE - send the response back to valid user!
+ *			GSM_WRITE_MESSAGE - queue the response back to valid user!
+ *			GSM_WAITING - chain of AT commands is running, its callbacks will change the state
+ *			Unsolicited result codes are handled by the handlers in URC_TABLE[] as they are received
  */
 void GSM_WaitAndProcessRequest()
 {
+	const char* command;
+
+	AT_SetURCTable(URC_TABLE, gTotalURCs);
+
 	//Inform the prime user that Initialization complete
 	gResponseCode = DEVICE_ON;
 	gGSMState = GSM_WRITE_MESSAGE;
 
 	while(1)
 	{
+		AT_Poll();
+
 		switch(gGSMState)
 		{
 			case GSM_IDLE:
-
-					USART_FlushReceiveBuffer();
-					
-					//Wait for either message or call to arrive!
-					while(!gReceive_Buffer_Full)
-						;
-					
-					if(compareStrings((const char*)gGSM_Response, RING_RESPONSE) == 0)
-					{
-						USART_FlushReceiveBuffer();
-						gGSMState = GSM_VOICE_CALL;
-					}
-					else if(compareStrings((const char*)gGSM_Response, GOT_MESSAGE_RESPONSE) == 0)
-					{
-						gGSMState = GSM_READ_MESSAGE;
-					}
-					
+#if (USE_MODEM_WATCHDOG != 0)
+				//Modem stopped answering the probes, it is restarted before anything else
+				if(gProbeFailures >= GSM_PROBE_FAILURES)
+				{
+					GSM_Recover();
+				}
+				else
+#endif	//USE_MODEM_WATCHDOG
+#if (USE_DIRECT_SMS != 0)
+				//Message delivered with +CMT is processed here, no need to read or delete it
+				if(gDirectPending == 0x02)
+				{
+					gResponseCode = GSM_ExecuteMessage(gDirectHeader, 1, gDirectMessage, strlen((const char*)gDirectMessage));	// 1st occurance of double quote
+					gDirectPending = 0;
+					gGSMState = GSM_WRITE_MESSAGE;
+				}
+				else
+#endif	//USE_DIRECT_SMS
+				//Messages left from the previous run are deleted before anything is listed
+				if(gStoragePurge && (!AT_QueueCommand(PSTR("AT+CMGDA=\"DEL ALL\""), 0, AT_END_LINE, OK_RESPONSE, GSM_PURGE_TIMEOUT, GSM_StoragePurged)))
+				{
+					gGSMState = GSM_WAITING;
+				}
+				//Messages are listed, unless the processed messages has to be deleted first
+				else if(gPendingMessage && (!gCleanupUrgent))
+				{
+					gPendingMessage = 0;
+					gGSMState = GSM_READ_MESSAGE;
+				}
+				//Storage is cleaned before the acknowledgements only when it is needed right now
+				else if((gCleanupUrgent || GSM_STORAGE_FULL()) && (!GSM_StorageCleanup(0x01)))
+				{
+					gGSMState = GSM_WAITING;
+				}
+				//Settings lost as the modem is restarted
+				else if(gSettingsWanted & (~gSettingsApplied))
+				{
+					gGSMState = GSM_WAITING;
+					GSM_RestoreSettings();
+				}
+				//Requests are taken first, acknowledgements are sent when nothing else is waiting.
+				//They would only time out without the network, so they wait till it is registered again
+				else if((gAckHead != gAckTail) && GSM_NETWORK_REGISTERED(gNetworkStatus))
+				{
+					gGSMState = GSM_WAITING;
+					GSM_AcknowledgeService();
+				}
+				//Latencies learnt by the AT engine are kept across the reset
+				else if(TIMER_Expired(gTimingsDeadline) && AT_TimingsChanged())
+				{
+					updateEEPROMBlock(AT_TIMINGS, (const uint8_t*)AT_GetTimings());
+					gTimingsDeadline = TIMER_GetTicks() + GSM_TIMINGS_SAVE_INTERVAL;
+				}
+				//Network and signal quality, for GET SIGNAL and to know when the registration is lost
+				else if(TIMER_Expired(gSignalDeadline) && (!GSM_SampleSignal()))
+				{
+					gGSMState = GSM_WAITING;
+				}
+#if (USE_MODEM_WATCHDOG != 0)
+				//Liveness of the modem, with the lightest command
+				else if(TIMER_Expired(gProbeDeadline) && (!AT_QueueCommand(PSTR("AT"), 0, AT_END_LINE, OK_RESPONSE, GSM_RESPONSE_TIMEOUT, GSM_ProbeDone)))
+				{
+					gGSMState = GSM_WAITING;
+				}
+#endif	//USE_MODEM_WATCHDOG
+				//Housekeeping when there is nothing else to do
+				else if(!GSM_StorageCleanup(0x00))
+				{
+					gGSMState = GSM_WAITING;
+				}
 				break;
 
 			case GSM_VOICE_CALL:
-					if(gReceive_Buffer_Full)
-					{
-					    if(gDeviceLicensed && (!GSM_CheckValidUser(1)))		// 1st occurance of double quote
-						{
-							GSM_HandleCall();
-						}
-						else
-						{
-							GSM_SendRequest("ATH0", OK_RESPONSE);
-#if(USE_DETAILED_RESPONSE != 0)
-							if(!gDeviceLicensed)
-							{
-								gResponseCode = NOT_LICENSED;
-								gGSMState = GSM_WRITE_MESSAGE;
-							}
-							else
-#endif	//USE_DETAILED_RESPONSE
-								gGSMState = GSM_IDLE;
-						}
-					}
+#if (USE_DTMF_CONTROL != 0)
+				//Call is cut if no key is pressed for a while
+				if(gCallSession && TIMER_Expired(gSessionDeadline))
+					GSM_EndCall();
+				break;
+#else
+				//Ring back calls are timed in the call as well
+				GSM_RingBackStep();
+				break;
+#endif	//USE_DTMF_CONTROL
+
+			case GSM_WAITING:
+				//Handled by the URC handlers and the callbacks, ring back calls are timed here
+				GSM_RingBackStep();
 				break;
 
 			case GSM_MISSED_CALL:
-				//Toggle Default Switch
-				if(gMissedCallFeature)
+				//Action of the missed call pattern
+				command = GSM_MissedCallCommand(gMissedCallAction);
+				if(gMissedCallFeature && command && (pgm_read_byte(command) != '\0'))
 				{
-					gCommand = (uint8_t*)"TOGGLE";
-					gResponseCode = processCommand();
-					USART_FlushReceiveBuffer();
+					gResponseCode = GSM_RunCommand(command);
 					//Change State to Writing message
 					gGSMState = GSM_WRITE_MESSAGE;
 				}
@@ -617,17 +2496,13 @@ void GSM_WaitAndProcessRequest()
 				break;
 
 			case GSM_READ_MESSAGE:
-					gResponseCode = GSM_ProcessMessage();
-					USART_FlushReceiveBuffer(); //For safer side
-					gGSMState = GSM_WRITE_MESSAGE;
+					gGSMState = GSM_WAITING;
+					GSM_ProcessMessage();
 				break;
 
 			case GSM_WRITE_MESSAGE:
-					USART_FlushReceiveBuffer();
-					//#if 0
 					if((gResponseCode == DEVICE_ON) || gServiceAcknowledgement)
-						GSM_AcknowledgeService();
-					//#endif
+						GSM_QueueAcknowledgement(gResponseCode);
 					gGSMState = GSM_IDLE;
 				break;
 
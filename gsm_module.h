@@ -16,8 +16,14 @@
  *************************************************************************************************/ 
 #include<stdio.h>
 #include<string.h>
+#include "atmega328p_clock.h"
 #include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "atmega328p_usart.h"
+#include "atmega328p_timer.h"
+#include "atmega328p_gpio.h"
+#include "at_engine.h"
+#include "sms_pdu.h"
 #include "printf_code.h"
 #include "wireless_control_config.h"
 #include "commands.h"
@@ -34,8 +40,59 @@ typedef enum
 	GSM_MISSED_CALL     = 0x02,
 	GSM_READ_MESSAGE    = 0x03,
 	GSM_WRITE_MESSAGE   = 0x04,
+	GSM_WAITING         = 0x05,	//Chain of AT commands is running
 }eGSM_States;
 
+/*************************************************************************************************
+ * #defines
+ *************************************************************************************************/
+#define GSM_ACK_QUEUE_LENGTH	4		// Must be power of 2!
+#define GSM_ACK_QUEUE_MASK		(GSM_ACK_QUEUE_LENGTH - 1)
+#define GSM_ACK_MAX_CODES		4		// Status codes merged into one acknowledgement
+#define GSM_NETWORK_TIMEOUT		60000	// Bring up continues without the network after this, +CREG tells when it is registered
+
+//Modem settings kept in the shadow, see GSM_ApplySetting()
+#define GSM_SETTING_ECHO_OFF	0x01	// ATE0
+#define GSM_SETTING_SMS_FORMAT	0x02	// AT+CMGF=1, AT+CMGF=0 with USE_PDU_MODE
+#define GSM_SETTING_STORAGE		0x04	// AT+CPMS="SM","SM","SM"
+#define GSM_SETTING_DIRECT_SMS	0x08	// AT+CNMI=2,2,0,0,0
+#define GSM_SETTING_CALLER_ID	0x10	// AT+CLIP=1
+#define GSM_SETTING_DTMF		0x20	// AT+DDET=1
+#define GSM_SETTING_NETWORK_URC	0x40	// AT+CREG=1
+
+//Phases of GSM_BringUp(), time at the end of each is kept
+#define GSM_PHASE_SYNC			0x00	// Modem answers AT
+#define GSM_PHASE_LINK			0x01	// Flow control and baud rate
+#define GSM_PHASE_CONFIG		0x02	// Settings on one command line
+#define GSM_PHASE_NETWORK		0x03	// Registered to the network
+#define GSM_TOTAL_PHASES		0x04
+
+#if (USE_MODEM_WATCHDOG != 0)
+//PWRKEY of the modem, driven through a NPN transistor. High on the pin pulls PWRKEY low
+#define GSM_PWRKEY_PORT			GPIOB
+#define GSM_PWRKEY_PIN			PIN_ONE
+#define GSM_PWRKEY_ACTIVE		GPIO_PIN_SET
+#define GSM_PWRKEY_INACTIVE		GPIO_PIN_RESET
+#endif	//USE_MODEM_WATCHDOG
+
+/*************************************************************************************************
+ * Strcuture Definitions
+ *************************************************************************************************/
+typedef struct
+{
+	uint32_t baudRate;
+	char command[14];		//AT command to set the baud rate in modem, table is kept in the flash
+	USARTModesType mode;	//Mode with least baud rate error for CLOCK_PROFILE
+}Struct_Baud_Rate;
+
+typedef struct
+{
+	uint8_t codes[GSM_ACK_MAX_CODES];	// Status codes from STATUS_CODE[], sent as one message
+	uint8_t count;			// Number of status codes
+	uint8_t length;			// Length of the message, status texts separated by "; "
+	uint8_t number[20];		// Phone number of the user to acknowledge
+}Struct_Acknowledgement;
+
 /*************************************************************************************************
  * Exported variables
  *************************************************************************************************/ 
@@ -51,7 +108,17 @@ void GSM_WaitAndProcessRequest();
 void GSM_ExtractArguement(uint8_t length);
 uint8_t GSM_TestForResponse();
 uint8_t GSM_SetEchoOFF();
+uint8_t GSM_ApplySetting(uint8_t);
+uint8_t GSM_NegotiateBaudRate();
+#if (USE_FLOW_CONTROL != 0)
+uint8_t GSM_EnableFlowControl();
+#endif	//USE_FLOW_CONTROL
+uint8_t GSM_CheckMissedCallPattern(const uint8_t*);
+uint8_t GSM_UserOperator();
+uint8_t GSM_ApplySettings(uint8_t);
 uint8_t GSM_SetupForSMS();
+uint8_t GSM_WaitForNetwork(uint32_t);
+uint8_t GSM_BringUp(uint32_t);
 
 	#endif	//USE_GSM_MODULE
 
@@ -23,37 +23,40 @@
   *
   * Software version: <Major_Release>_<Minor_Release>_<Bug_Fix>
   */
-const uint8_t gProductVersion[] = "HWV_1_1_1_0_0; SWV_V_3_5_3";
+const uint8_t gProductVersion[] PROGMEM = "HWV_1_1_1_0_0; SWV_V_3_5_3";
 
 /*************************************************************************************************
  * Function Definition
  *************************************************************************************************/
 int main(void)
 {
+	CLOCK_Init();
+	TIMER_Init();		//1ms tick, runs once the Global interrupt is enabled
+
 #if (USE_USART_DRIVER > 0)
 	//Driver part
 	USART_StructureType USART_Config;
 
     //USART_Config.USART_BaudRate = 19200;
-    USART_Config.USART_BaudRate = 9600;
+    USART_Config.USART_BaudRate = USART_BASE_BAUD_RATE;
     USART_Config.USART_Communication = BOTH;
     USART_Config.USART_DataBits = EIGHT;
-    USART_Config.USART_Modes = ASYNCHRONOUS;
+    USART_Config.USART_Modes = USART_BASE_MODE;	// Double speed, if the baud rate error is high with CLOCK_PROFILE
     USART_Config.USART_Parity = NOPARITY;
     USART_Config.USART_StopBits = ONESTOPBIT;
 
     USARTInit(USART_Config);
 
     USART_EnableInterrupt(RECEIVE);
+ #if(USE_DEBUG_TRACE != 0)
+	SOFTUART_Init();
+	DEBUG_TRACE("<boot: %S>\r\n", gProductVersion);
+ #endif // USE_DEBUG_TRACE
  #if(USE_GSM_MODULE != 0)
 
-	while(GSM_TestForResponse())	//Wait for Network to get acquired!
-		;
-
-	GSM_SetEchoOFF();
-	GSM_SetupForSMS();
+	initializeDevice();	//Before the bring-up, it takes the learnt AT timings
 
-	initializeDevice();
+	GSM_BringUp(GSM_NETWORK_TIMEOUT);		//Sync, link, configuration and network registration
 
 	//Enable for testing Licensing!
 	//gDeviceLicensed = 0;
@@ -16,11 +16,13 @@
 *******************************************************************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "atmega328p_clock.h"
 #include <util/delay.h>
 #include "wireless_control_config.h"
 #include "printf_code.h"
 #include "scanf_code.h"
 #include "atmega328p_usart.h"
+#include "atmega328p_timer.h"
 #include "eeprom_storage.h"
 #include "take_action.h"
  #if(USE_GSM_MODULE != 0)
@@ -15,6 +15,8 @@
 
 uint32_t gIntegerMask = 0xFF;
 
+static void (*gDisplaySink)(uint16_t) = USART_PutChar;	// print() writes to USART, debugPrint() to the software UART
+
 /* Function Definations ------------------------------------------------------*/
 
 /**
@@ -26,7 +28,7 @@ uint32_t gIntegerMask = 0xFF;
   */
 void display_Character(char ch)
 {
-	USART_PutChar(ch);
+	gDisplaySink(ch);
 	//putchar(ch);
 }
 
@@ -46,6 +48,24 @@ void print_String(const char *str)
 	}
 }
 
+/**
+  * @name   print_String_P()
+  * @brief  this function will print the string kept in the flash
+  * @param  *str - the pointer to the string in the flash, ex: PSTR("text")
+  * @note	-
+  * @retval None
+  */
+void print_String_P(const char *str)
+{
+	char ch;
+
+	while((ch = pgm_read_byte(str)) != '\0')
+	{
+		display_Character(ch);
+		str++;
+	}
+}
+
 /**
   * @name   print_Character()
   * @brief  this function will print the character only!
@@ -131,28 +151,40 @@ void print_Integer(const int32_t data, int length)
 
 
 /**
-  * @name   print()
-  * @brief  this function will behave similar to printf but the fully functional printf, a partial printf function!
+  * @name   read_Character()
+  * @brief  this function will read the character of the format
+  * @param  *str - pointer to the character
+  * @param  flash - 1 if str is in the flash, 0 if it is in the RAM
+  * @note	-
+  * @retval Character at str
+  */
+static char read_Character(const char *str, uint8_t flash)
+{
+	return flash ? (char)pgm_read_byte(str) : *str;
+}
+
+/**
+  * @name   print_Formatted()
+  * @brief  this function will format the string and print it to the current sink
   * @param  *str - pointer to the string which needs to be analysed and printed!
-  * @param  ... - unknown number of arguments!
+  * @param  flash - 1 if str is in the flash (PSTR), 0 if it is in the RAM
+  * @param  arg_list - arguments for the format specifiers
   * @note	for printing unsinged numbers, hex values and long values needs modification!
   *         For integers typecast the number by (uint32_t) or (int32_t) to print the proper value
+  *         %S prints a string argument which is in the flash
   * @retval None
   */
-void print(const char *str, ...)
+static void print_Formatted(const char *str, uint8_t flash, va_list arg_list)
 {
-	va_list arg_list;
-
-	va_start(arg_list, str);
-	while(*str != '\0')
+	while(read_Character(str, flash) != '\0')
 	{
-		switch(*str)
+		switch(read_Character(str, flash))
 		{
 			case '%':
 						str++;
-						if(*str != '%')
+						if(read_Character(str, flash) != '%')
 						{
-							switch(*str)
+							switch(read_Character(str, flash))
 							{
 								case 'd':	//print the Integers!
 								case 'x':
@@ -161,7 +193,7 @@ void print(const char *str, ...)
 											//Note: These int or uint variable must have postfixed with _t, like int8_t or uint8_t
 											//      Else the print values may be different from what has been passed!
 											//      if _t is used then size is always fixed to those many bits!
-											print_Integer(va_arg(arg_list, const int32_t), (*str=='d'? 10: 8));
+											print_Integer(va_arg(arg_list, const int32_t), (read_Character(str, flash)=='d'? 10: 8));
 										break;
 								case 'c':
 											print_Character(va_arg(arg_list, const int));
@@ -169,34 +201,113 @@ void print(const char *str, ...)
 								case 's':
 											print_String(va_arg(arg_list, const char *));
 										break;
+								case 'S':
+											print_String_P(va_arg(arg_list, const char *));
+										break;
 
 								default:
-										display_Character(*str);
+										display_Character(read_Character(str, flash));
 										break;
 							}
 						}
 						else
 						{
 							//Here 2 times % symbol is invalid (you cannot use %%)
-							print("Error Error Error! cannot print becasue format specifier is entered twice!");
+							print_String_P(PSTR("Error Error Error! cannot print becasue format specifier is entered twice!"));
 						}
 
 					break;
 
 			default:
-                        if(*str == 0x5C)    //Comparing with \ character
+                        if(read_Character(str, flash) == 0x5C)    //Comparing with \ character
                         {
-                            if(*(str + 1) != 0x22)  //COmparing with " quotes
-                                display_Character(*str);
+                            if(read_Character(str + 1, flash) != 0x22)  //COmparing with " quotes
+                                display_Character(read_Character(str, flash));
                         }
                         else
-                            display_Character(*str);
+                            display_Character(read_Character(str, flash));
 					break;
 		}
 		str++;
 	}
+}
+
+/**
+  * @name   print()
+  * @brief  this function will behave similar to printf but the fully functional printf, a partial printf function!
+  * @param  *str - pointer to the string which needs to be analysed and printed!
+  * @param  ... - unknown number of arguments!
+  * @note	for printing unsinged numbers, hex values and long values needs modification!
+  *         For integers typecast the number by (uint32_t) or (int32_t) to print the proper value
+  * @retval None
+  */
+void print(const char *str, ...)
+{
+	va_list arg_list;
+
+	va_start(arg_list, str);
+	gDisplaySink = USART_PutChar;
+	print_Formatted(str, 0, arg_list);
+	va_end(arg_list);
+}
+
+/**
+  * @name   print_P()
+  * @brief  this function is same as print() but the format is kept in the flash
+  * @param  *str - pointer to the format in the flash, ex: PSTR("AT+CMGD=%s")
+  * @param  ... - unknown number of arguments!
+  * @note	String arguments for %s are in the RAM, for %S in the flash
+  * @retval None
+  */
+void print_P(const char *str, ...)
+{
+	va_list arg_list;
+
+	va_start(arg_list, str);
+	gDisplaySink = USART_PutChar;
+	print_Formatted(str, 1, arg_list);
+	va_end(arg_list);
+}
+
+#if (USE_DEBUG_TRACE != 0)
+/**
+  * @name   debugPrint()
+  * @brief  this function is same as print() but the data is sent on the software UART debug channel
+  * @param  *str - pointer to the string which needs to be analysed and printed!
+  * @param  ... - unknown number of arguments!
+  * @note	Use DEBUG_TRACE() macro, so that the trace is removed when USE_DEBUG_TRACE is 0
+  * @retval None
+  */
+void debugPrint(const char *str, ...)
+{
+	va_list arg_list;
+
+	va_start(arg_list, str);
+	gDisplaySink = SOFTUART_PutChar;
+	print_Formatted(str, 0, arg_list);
+	gDisplaySink = USART_PutChar;
+	va_end(arg_list);
+}
+
+/**
+  * @name   debugPrint_P()
+  * @brief  this function is same as debugPrint() but the format is kept in the flash
+  * @param  *str - pointer to the format in the flash
+  * @param  ... - unknown number of arguments!
+  * @note	Used by DEBUG_TRACE() macro, so that the trace formats take no RAM
+  * @retval None
+  */
+void debugPrint_P(const char *str, ...)
+{
+	va_list arg_list;
+
+	va_start(arg_list, str);
+	gDisplaySink = SOFTUART_PutChar;
+	print_Formatted(str, 1, arg_list);
+	gDisplaySink = USART_PutChar;
 	va_end(arg_list);
 }
+#endif	//USE_DEBUG_TRACE
 
 /**
   * @name   main()
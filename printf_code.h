@@ -18,7 +18,12 @@
 #include <stdarg.h>
 //#include <strings.h>
 #include <stdlib.h>
+#include <avr/pgmspace.h>
 #include "atmega328p_usart.h"
+#include "wireless_control_config.h"
+ #if(USE_DEBUG_TRACE != 0)
+#include "atmega328p_softuart.h"
+ #endif // USE_DEBUG_TRACE
 
 /* Exported types ------------------------------------------------------------*/
 
@@ -27,8 +32,18 @@ extern uint32_t gIntegerMask;
 /* Exported constants --------------------------------------------------------*/
 
 /* Exported macro ------------------------------------------------------------*/
+#if (USE_DEBUG_TRACE != 0)
+#define DEBUG_TRACE(format, ...)	debugPrint_P(PSTR(format), ##__VA_ARGS__)	// Format is kept in the flash
+#else
+#define DEBUG_TRACE(...)
+#endif // USE_DEBUG_TRACE
 
 /* Exported functions ------------------------------------------------------- */
 extern void print(const char *str, ...);
+extern void print_P(const char *str, ...);
+#if (USE_DEBUG_TRACE != 0)
+extern void debugPrint(const char *str, ...);
+extern void debugPrint_P(const char *str, ...);
+#endif // USE_DEBUG_TRACE
 
 #endif // __PRINTF_CODE_H
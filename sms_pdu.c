@@ -0,0 +1,468 @@
+/**
+  ******************************************************************************
+  * @file    sms_pdu.c
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This file encodes and decodes the SMS in PDU mode (AT+CMGF=0)
+  ******************************************************************************
+  *
+  *					HOW TO USE
+  * 1. PDU_Decode() takes the hex line of SMS-DELIVER (after +CMGL or +CMT) and fills Struct_SMS in one pass.
+  *    Nothing is allocated and the line is not changed. Sender and message are not searched with the quotes,
+  *    so quotes and commas in the message do not matter.
+  * 2. PDU_Encode() makes the hex line of SMS-SUBMIT with 7 bit message. Its return value is the length for AT+CMGS.
+  * 3. Numbers are semi-octets with the digits swapped, time stamp is semi-octets as well.
+  *    7 bit characters are packed, 8 septets in 7 octets. Characters which are not in GSM default alphabet are '?'
+  ******************************************************************************
+  */
+
+/*************************************************************************************************
+ * #includes
+ *************************************************************************************************/
+#include "sms_pdu.h"
+
+	#if(USE_PDU_MODE != 0)
+/*************************************************************************************************
+ * #defines
+ *************************************************************************************************/
+#define PDU_TYPE_MASK			0x03	// TP-MTI in the first octet
+#define PDU_TYPE_DELIVER		0x00
+#define PDU_TYPE_SUBMIT			0x01
+#define PDU_UDHI				0x40	// User data starts with the header
+#define PDU_TOA_INTERNATIONAL	0x91
+#define PDU_TOA_NATIONAL		0x81
+#define PDU_TON_MASK			0x70
+#define PDU_TON_INTERNATIONAL	0x10
+#define PDU_TON_ALPHANUMERIC	0x50
+#define PDU_ESCAPE				0x1B	// Next septet is from the extension table
+
+/*************************************************************************************************
+ * Strcuture Definitions
+ *************************************************************************************************/
+typedef struct
+{
+	const char* hex;		// Next hex digit
+	uint8_t error;			// Set once a character is not a hex digit, nothing is read after that
+	uint16_t bits;			// Bits of the octets which are not taken as septets yet
+	uint8_t bitCount;
+}Struct_PDU_Reader;
+
+typedef struct
+{
+	char* hex;				// Next hex digit
+	uint16_t bits;			// Bits of the septets which are not written as octets yet
+	uint8_t bitCount;
+}Struct_PDU_Writer;
+
+/*************************************************************************************************
+ * Global Variables and Definition
+ *************************************************************************************************/
+static const char* HEX_DIGITS = "0123456789ABCDEF";
+static const char* NUMBER_DIGITS = "0123456789*#abc";
+
+//Extension table of GSM default alphabet, septet after PDU_ESCAPE
+static const struct
+{
+	uint8_t septet;
+	uint8_t ascii;
+}EXTENSION[] =
+{
+	{0x14, '^'},
+	{0x28, '{'},
+	{0x29, '}'},
+	{0x2F, '\\'},
+	{0x3C, '['},
+	{0x3D, '~'},
+	{0x3E, ']'},
+	{0x40, '|'},
+};
+static const uint8_t gTotalExtensions = sizeof(EXTENSION)/sizeof(EXTENSION[0]);
+
+/*************************************************************************************************
+ * Function Definition
+ *************************************************************************************************/
+/*
+ * @name   	PDU_FromGSM()
+ * @brief	This function converts the septet of GSM default alphabet to ASCII
+ * @param  	septet  - character in GSM default alphabet
+ *			escaped - 0x01 if the septet is after PDU_ESCAPE
+ * @retval	ASCII character, '?' if there is no ASCII character for it
+ */
+static uint8_t PDU_FromGSM(uint8_t septet, uint8_t escaped)
+{
+	uint8_t i;
+
+	if(escaped)
+	{
+		for(i = 0; i < gTotalExtensions; i++)
+		{
+			if(EXTENSION[i].septet == septet)
+				return EXTENSION[i].ascii;
+		}
+		return '?';
+	}
+
+	switch(septet)
+	{
+		case 0x00:	return '@';
+		case 0x02:	return '$';
+		case 0x0A:	return '\n';
+		case 0x0D:	return '\r';
+		case 0x11:	return '_';
+		default:	break;
+	}
+
+	//Space to Z and a to z are same as ASCII, except currency sign and inverted exclamation mark
+	if(((septet >= 0x20) && (septet <= 0x5A) && (septet != 0x24) && (septet != 0x40)) || ((septet >= 0x61) && (septet <= 0x7A)))
+		return septet;
+
+	return '?';
+}
+
+/*
+ * @name   	PDU_ToGSM()
+ * @brief	This function converts the ASCII character to GSM default alphabet
+ * @param  	ascii  - ASCII character
+ *			septet - GSM character, or the septet after PDU_ESCAPE
+ * @retval	Number of septets for the character, 2 if it is in the extension table
+ */
+static uint8_t PDU_ToGSM(uint8_t ascii, uint8_t* septet)
+{
+	uint8_t i;
+
+	for(i = 0; i < gTotalExtensions; i++)
+	{
+		if(EXTENSION[i].ascii == ascii)
+		{
+			*septet = EXTENSION[i].septet;
+			return 2;
+		}
+	}
+
+	switch(ascii)
+	{
+		case '@':	*septet = 0x00;		break;
+		case '$':	*septet = 0x02;		break;
+		case '_':	*septet = 0x11;		break;
+		default:
+			*septet = (PDU_FromGSM(ascii, 0) == ascii) ? ascii : '?';
+			break;
+	}
+
+	return 1;
+}
+
+/*
+ * @name   	PDU_ReadOctet()
+ * @brief	This function reads the octet from 2 hex digits
+ * @param  	reader - position in the hex line
+ * @retval	Octet, 0 if the line is not valid (reader->error is set)
+ */
+static uint8_t PDU_ReadOctet(Struct_PDU_Reader* reader)
+{
+	uint8_t octet = 0;
+	uint8_t i;
+	char digit;
+
+	if(reader->error)
+		return 0;
+
+	for(i = 0; i < 2; i++)
+	{
+		digit = reader->hex[i];
+		octet <<= 4;
+		if((digit >= '0') && (digit <= '9'))
+			octet |= digit - '0';
+		else if((digit >= 'A') && (digit <= 'F'))
+			octet |= digit - 'A' + 10;
+		else if((digit >= 'a') && (digit <= 'f'))
+			octet |= digit - 'a' + 10;
+		else
+		{
+			reader->error = 1;
+			return 0;
+		}
+	}
+	reader->hex += 2;
+
+	return octet;
+}
+
+/*
+ * @name   	PDU_ReadSeptets()
+ * @brief	This function reads the packed 7 bit characters and converts them to ASCII
+ * @param  	reader - position in the hex line, at the octet which has the first septet
+ *			count  - number of septets to read
+ *			skip   - fill bits before the first septet (after the user data header)
+ *			text   - ASCII characters, null terminated
+ *			size   - maximum characters in text, rest of the septets are read but dropped
+ * @retval	Number of characters in text
+ * @note	Octets are read only when the bits are needed, so the reader stops at the end of the data
+ */
+static uint8_t PDU_ReadSeptets(Struct_PDU_Reader* reader, uint8_t count, uint8_t skip, uint8_t* text, uint8_t size)
+{
+	uint8_t length = 0;
+	uint8_t escaped = 0;
+	uint8_t septet;
+
+	reader->bits = 0;
+	reader->bitCount = 0;
+	if(skip)
+	{
+		reader->bits = PDU_ReadOctet(reader) >> skip;
+		reader->bitCount = 8 - skip;
+	}
+
+	while(count--)
+	{
+		if(reader->bitCount < 7)
+		{
+			reader->bits |= (uint16_t)PDU_ReadOctet(reader) << reader->bitCount;
+			reader->bitCount += 8;
+		}
+		septet = reader->bits & 0x7F;
+		reader->bits >>= 7;
+		reader->bitCount -= 7;
+
+		if(septet == PDU_ESCAPE)
+		{
+			escaped = 1;
+			continue;
+		}
+
+		if(length < size)
+			text[length++] = PDU_FromGSM(septet, escaped);
+		escaped = 0;
+	}
+	text[length] = '\0';
+
+	return length;
+}
+
+/*
+ * @name   	PDU_ReadNumber()
+ * @brief	This function reads the address (sender of the message)
+ * @param  	reader - position in the hex line, at the address length
+ *			number - phone number, '+' is added for the international number
+ * @retval	None
+ * @note	Length of the address is in digits (semi-octets). Alphanumeric address is packed 7 bit characters.
+ */
+static void PDU_ReadNumber(Struct_PDU_Reader* reader, uint8_t* number)
+{
+	uint8_t digits = PDU_ReadOctet(reader);
+	uint8_t type = PDU_ReadOctet(reader);
+	uint8_t octet;
+	uint8_t length = 0;
+	uint8_t i;
+
+	if((type & PDU_TON_MASK) == PDU_TON_ALPHANUMERIC)
+	{
+		PDU_ReadSeptets(reader, (digits * 4) / 7, 0, number, PDU_NUMBER_LENGTH);
+		return;
+	}
+
+	if((type & PDU_TON_MASK) == PDU_TON_INTERNATIONAL)
+		number[length++] = '+';
+
+	for(i = 0; i < digits; i++)
+	{
+		//Low semi-octet is the first digit, F fills the last octet of the odd number of digits
+		if((i & 0x01) == 0)
+			octet = PDU_ReadOctet(reader);
+		else
+			octet >>= 4;
+
+		if(length < PDU_NUMBER_LENGTH)
+			number[length++] = NUMBER_DIGITS[octet & 0x0F];
+	}
+	number[length] = '\0';
+}
+
+/*
+ * @name   	PDU_Decode()
+ * @brief	This function decodes the SMS-DELIVER in hex
+ * @param  	hex - PDU line, with the SMSC address at the start
+ *			sms - decoded message
+ * @retval	0x00	- if the message is decoded
+ *			0xFF	- if the line is not SMS-DELIVER or not valid hex
+ * @note	User data header (ex: concatenated message) is skipped. UCS2 characters other than ASCII are '?'
+ */
+uint8_t PDU_Decode(const char* hex, Struct_SMS* sms)
+{
+	Struct_PDU_Reader reader;
+	uint8_t firstOctet;
+	uint8_t dcs;
+	uint8_t octet;
+	uint8_t dataLength;
+	uint8_t headerLength = 0;
+	uint8_t i;
+
+	reader.hex = hex;
+	reader.error = 0;
+
+	//SMSC is not used
+	octet = PDU_ReadOctet(&reader);
+	while(octet--)
+		PDU_ReadOctet(&reader);
+
+	firstOctet = PDU_ReadOctet(&reader);
+	if((firstOctet & PDU_TYPE_MASK) != PDU_TYPE_DELIVER)
+		return 0xFF;
+
+	PDU_ReadNumber(&reader, sms->sender);
+	PDU_ReadOctet(&reader);		// Protocol identifier
+	dcs = PDU_ReadOctet(&reader);
+
+	//Time stamp, semi-octets with the digits swapped. Bit 3 of the time zone is the sign
+	for(i = 0; i < 7; i++)
+	{
+		octet = PDU_ReadOctet(&reader);
+		if(i < 6)
+			sms->timestamp[i] = ((octet & 0x0F) * 10) + (octet >> 4);
+		else
+			sms->timestamp[i] = (octet & 0x08) ? (uint8_t)(-(((octet & 0x07) * 10) + (octet >> 4))) : (((octet & 0x07) * 10) + (octet >> 4));
+	}
+
+	//Alphabet from the data coding scheme, general coding group or message class group
+	if((dcs & 0x80) == 0x00)
+		sms->coding = ((dcs & 0x0C) == 0x08) ? PDU_CODING_UCS2 : (((dcs & 0x0C) == 0x04) ? PDU_CODING_8BIT : PDU_CODING_7BIT);
+	else if((dcs & 0xF0) == 0xF0)
+		sms->coding = (dcs & 0x04) ? PDU_CODING_8BIT : PDU_CODING_7BIT;
+	else
+		sms->coding = ((dcs & 0xF0) == 0xE0) ? PDU_CODING_UCS2 : PDU_CODING_7BIT;
+
+	dataLength = PDU_ReadOctet(&reader);	// Septets for 7 bit, octets otherwise
+	if(firstOctet & PDU_UDHI)
+	{
+		headerLength = PDU_ReadOctet(&reader) + 1;	// With its length octet
+		for(i = 1; i < headerLength; i++)
+			PDU_ReadOctet(&reader);
+	}
+
+	if(sms->coding == PDU_CODING_7BIT)
+	{
+		//Header takes whole septets, fill bits are after it
+		i = ((headerLength * 8) + 6) / 7;
+		sms->length = PDU_ReadSeptets(&reader, (dataLength > i) ? (dataLength - i) : 0, (i * 7) - (headerLength * 8), sms->data, PDU_MAX_DATA);
+	}
+	else
+	{
+		dataLength = (dataLength > headerLength) ? (dataLength - headerLength) : 0;
+		sms->length = 0;
+		for(i = 0; i < dataLength; i++)
+		{
+			octet = PDU_ReadOctet(&reader);
+			if(sms->coding == PDU_CODING_UCS2)
+			{
+				//High octet first, only ASCII is kept
+				if((i & 0x01) == 0)
+				{
+					firstOctet = octet;
+					continue;
+				}
+				octet = ((firstOctet == 0) && (octet < 0x80)) ? octet : '?';
+			}
+			if(sms->length < PDU_MAX_DATA)
+				sms->data[sms->length++] = octet;
+		}
+		sms->data[sms->length] = '\0';
+	}
+
+	return reader.error ? 0xFF : 0x00;
+}
+
+/*
+ * @name   	PDU_WriteOctet()
+ * @brief	This function writes the octet as 2 hex digits
+ * @param  	writer - position in the hex line
+ *			octet  - octet to write
+ * @retval	None
+ */
+static void PDU_WriteOctet(Struct_PDU_Writer* writer, uint8_t octet)
+{
+	writer->hex[0] = HEX_DIGITS[octet >> 4];
+	writer->hex[1] = HEX_DIGITS[octet & 0x0F];
+	writer->hex += 2;
+}
+
+/*
+ * @name   	PDU_WriteSeptet()
+ * @brief	This function packs the septet, octets are written once 8 bits are there
+ * @param  	writer - position in the hex line
+ *			septet - 7 bit character
+ * @retval	None
+ */
+static void PDU_WriteSeptet(Struct_PDU_Writer* writer, uint8_t septet)
+{
+	writer->bits |= (uint16_t)septet << writer->bitCount;
+	writer->bitCount += 7;
+	if(writer->bitCount >= 8)
+	{
+		PDU_WriteOctet(writer, writer->bits & 0xFF);
+		writer->bits >>= 8;
+		writer->bitCount -= 8;
+	}
+}
+
+/*
+ * @name   	PDU_Encode()
+ * @brief	This function encodes the SMS-SUBMIT with 7 bit message in hex
+ * @param  	number - phone number, international if it starts with '+'
+ *			text   - message in ASCII, null terminated. Characters after maxSeptets septets are dropped
+ *			hex    - PDU line, null terminated. Should have PDU_SUBMIT_HEX_LENGTH(maxSeptets) characters
+ *			maxSeptets - septets of the message which fit in hex, not more than PDU_MAX_DATA
+ * @retval	Length of the PDU for AT+CMGS=<length>, SMSC address is not counted
+ * @note	SMSC of the SIM is used (SMSC length 00), validity period is not given
+ */
+uint8_t PDU_Encode(const char* number, const uint8_t* text, char* hex, uint8_t maxSeptets)
+{
+	Struct_PDU_Writer writer;
+	uint8_t international = (number[0] == '+') ? 0x01 : 0x00;
+	uint8_t digits;
+	uint8_t septets = 0;
+	uint8_t length;
+	uint8_t septet;
+	uint8_t i;
+
+	writer.hex = hex;
+	writer.bits = 0;
+	writer.bitCount = 0;
+
+	PDU_WriteOctet(&writer, 0x00);				// SMSC from the SIM
+	PDU_WriteOctet(&writer, PDU_TYPE_SUBMIT);
+	PDU_WriteOctet(&writer, 0x00);				// Message reference is set by the modem
+
+	//Destination address, semi-octets with the digits swapped
+	number += international;
+	digits = strlen(number);
+	if(digits > PDU_NUMBER_LENGTH)
+		digits = PDU_NUMBER_LENGTH;
+	PDU_WriteOctet(&writer, digits);
+	PDU_WriteOctet(&writer, international ? PDU_TOA_INTERNATIONAL : PDU_TOA_NATIONAL);
+	for(i = 0; i < digits; i += 2)
+		PDU_WriteOctet(&writer, ((((i + 1) < digits) ? (number[i + 1] - '0') : 0x0F) << 4) | (number[i] - '0'));
+
+	PDU_WriteOctet(&writer, 0x00);				// Protocol identifier
+	PDU_WriteOctet(&writer, 0x00);				// 7 bit, no message class
+
+	//Septets are counted first for the user data length
+	for(i = 0; (text[i] != '\0') && ((septets + PDU_ToGSM(text[i], &septet)) <= maxSeptets); i++)
+		septets += PDU_ToGSM(text[i], &septet);
+	length = i;
+	PDU_WriteOctet(&writer, septets);
+
+	for(i = 0; i < length; i++)
+	{
+		if(PDU_ToGSM(text[i], &septet) == 2)
+			PDU_WriteSeptet(&writer, PDU_ESCAPE);
+		PDU_WriteSeptet(&writer, septet);
+	}
+	if(writer.bitCount)
+		PDU_WriteOctet(&writer, writer.bits & 0xFF);
+	*writer.hex = '\0';
+
+	return ((writer.hex - hex) / 2) - 1;
+}
+
+	#endif	//USE_PDU_MODE
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    sms_pdu.h
+  * @author  Basavaraju B V
+  * @version V1.0.0
+  * @date    17-Oct-2026
+  * @brief   This is a header file for sms_pdu.c
+  ******************************************************************************
+  */
+
+#ifndef _SMS_PDU_H_
+#define _SMS_PDU_H_
+
+/*************************************************************************************************
+ * #includes
+ *************************************************************************************************/
+#include<stdint.h>
+#include<string.h>
+#include "wireless_control_config.h"
+
+/*************************************************************************************************
+ * #defines
+ *************************************************************************************************/
+#define PDU_NUMBER_LENGTH		20		// Digits of the phone number, with '+'
+#define PDU_MAX_DATA			160		// Septets of 7 bit message, 140 octets for 8 bit
+#define PDU_SUBMIT_HEADER		18		// SMSC, header with 20 digit number and the user data length of SMS-SUBMIT
+#define PDU_SUBMIT_HEX_LENGTH(septets)	(((PDU_SUBMIT_HEADER + ((((septets) * 7) + 7) / 8)) * 2) + 1)	// Hex line of SMS-SUBMIT with these many septets
+#define PDU_HEX_LENGTH			PDU_SUBMIT_HEX_LENGTH(PDU_MAX_DATA)
+
+//Alphabet of the message, from the data coding scheme
+#define PDU_CODING_7BIT			0x00	// GSM default alphabet, converted to ASCII
+#define PDU_CODING_8BIT			0x01	// Binary, octets as they are
+#define PDU_CODING_UCS2			0x02	// Characters other than ASCII are replaced by '?'
+
+/*************************************************************************************************
+ * Strcuture Definitions
+ *************************************************************************************************/
+typedef struct
+{
+	uint8_t sender[PDU_NUMBER_LENGTH + 1];	// International number starts with '+', alphanumeric sender is text
+	uint8_t timestamp[7];		// Year (2 digits), month, day, hour, minute, second and time zone in quarter hours (signed)
+	uint8_t coding;				// PDU_CODING_xxx
+	uint8_t length;				// Characters (7 bit, UCS2) or octets (8 bit) in data
+	uint8_t data[PDU_MAX_DATA + 1];	// Null terminated, 8 bit data can have null in it
+}Struct_SMS;
+
+/*************************************************************************************************
+ * Exported Functions
+ *************************************************************************************************/
+uint8_t PDU_Decode(const char*, Struct_SMS*);
+uint8_t PDU_Encode(const char*, const uint8_t*, char*, uint8_t);
+
+#endif	//_SMS_PDU_H_
@@ -64,6 +64,25 @@ uint8_t toggleDefaultSwitch()
 	return retVal;
 }
 
+/*
+ * @name   	toggleSwitch()
+ * @brief	This function will toggle the switch which is passed on as the arguement
+ * @param  	uint8_t - Switch, which has to be toggled. DEFAULT_SWITCH or SECOND_SWITCH
+ * @retval	uin8_t - SWITCHED OFF or ON information
+ * @note	Used by the missed call patterns to toggle the switches other than the default switch
+ */
+uint8_t toggleSwitch(uint8_t whichOne)
+{
+	if(getStatus(whichOne))
+	{
+		turnOFF(whichOne);
+		return SUCCESSFULLY_SWITCHED_OFF;
+	}
+
+	turnON(whichOne);
+	return SUCCESSFULLY_SWITCHED_ON;
+}
+
 /*
  * @name   	turnON()
  * @brief	This function will turn ON the switch which is passed on as the arguement
@@ -37,6 +37,7 @@ extern uint8_t gSecondSwitchState;
 void turnON(uint8_t);
 void turnOFF(uint8_t);
 uint8_t toggleDefaultSwitch();
+uint8_t toggleSwitch(uint8_t);
 void updateSwitches();
 uint8_t getStatus(uint8_t);
 
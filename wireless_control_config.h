@@ -11,6 +11,19 @@
 #ifndef _WIRELESS_CONTROL_CONFIG_H_
 #define _WIRELESS_CONTROL_CONFIG_H_
 
+/***************************************************************
+CLOCK_PROFILE:
+Selects the clock source. Fuse bytes, F_CPU, system clock prescaler and the baud rate divisors are derived from it.
+Check atmega328p_clock.h file for details
+*/
+#define CLOCK_1MHZ_RC		1		// Internal RC oscillator with CKDIV8, default fuses of the chip
+#define CLOCK_8MHZ_RC		2		// Internal RC oscillator without CKDIV8
+#define CLOCK_16MHZ_XTAL	3		// External 16MHz crystal
+
+#ifndef CLOCK_PROFILE
+#define CLOCK_PROFILE	CLOCK_1MHZ_RC
+#endif // CLOCK_PROFILE
+
 /***************************************************************
 Set to 1, if GPIO Driver is used
 */
@@ -33,6 +46,65 @@ Set to 1, if GSM module is used
 #define USE_GSM_MODULE 	1
 #endif	//USE_GSM_MODULE
 
+/**************************************************************
+USE_FLOW_CONTROL:
+If it is set to 1, RTS/CTS hardware flow control is used with the modem (RTS - PD4, CTS - PD5). Check atmega328p_usart.h file for details
+Needed at higher baud rates, so that no data is lost while main loop is busy
+*/
+#ifndef USE_FLOW_CONTROL
+#define USE_FLOW_CONTROL 	0
+#endif	//USE_FLOW_CONTROL
+
+/**************************************************************
+USE_DEBUG_TRACE:
+If it is set to 1, debug messages are sent on the software UART (Timer2 and PB0). Check atmega328p_softuart.h file for details
+USART is used by GSM module, so debug messages cannot be sent on it
+*/
+#ifndef USE_DEBUG_TRACE
+#define USE_DEBUG_TRACE 	0
+#endif	//USE_DEBUG_TRACE
+
+/**************************************************************
+USE_DIRECT_SMS:
+If it is set to 1, messages are delivered directly on the USART as +CMT (AT+CNMI=2,2,0,0,0) and are never stored in SIM
+Reading and deleting the messages from SIM is not needed, so the commands are handled back to back
+If it is set to 0, messages are stored in SIM, read with AT+CMGR after +CMTI and deleted
+*/
+#ifndef USE_DIRECT_SMS
+#define USE_DIRECT_SMS 	0
+#endif	//USE_DIRECT_SMS
+
+/**************************************************************
+USE_PDU_MODE:
+If it is set to 1, messages are read and sent in PDU mode (AT+CMGF=0). Sender and message are decoded from the PDU,
+so quotes and commas in the message do not matter. Check sms_pdu.h file for details
+Needs about 500 bytes more RAM for the decoded message and the PDU of the acknowledgement
+If it is set to 0, text mode (AT+CMGF=1) is used
+*/
+#ifndef USE_PDU_MODE
+#define USE_PDU_MODE 	0
+#endif	//USE_PDU_MODE
+
+/**************************************************************
+USE_DTMF_CONTROL:
+If it is set to 1, call from the valid user is answered after the rings and the keys pressed are taken as commands
+(AT+DDET=1). Each command is confirmed with the tones (AT+VTS). Check DTMF_KEYS[] in gsm_module.c file for the keys
+If it is set to 0, call is cut after the rings
+*/
+#ifndef USE_DTMF_CONTROL
+#define USE_DTMF_CONTROL 	1
+#endif	//USE_DTMF_CONTROL
+
+/**************************************************************
+USE_MODEM_WATCHDOG:
+If it is set to 1, modem is probed with AT while it is idle. When it stops answering, it is restarted with the PWRKEY
+(GSM_PWRKEY_PORT and GSM_PWRKEY_PIN in gsm_module.h, through a transistor) and brought up again. Check GET RECOVERY command
+If it is set to 0, hung modem needs a manual power cycle
+*/
+#ifndef USE_MODEM_WATCHDOG
+#define USE_MODEM_WATCHDOG 	0
+#endif	//USE_MODEM_WATCHDOG
+
 /**************************************************************
 USE_DETAILED_RESPONSE:
 If it is set to 0 Only SUCCESS or FAILED will be acknowledged